@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Memory for temporaries of array evaluation.
+//
+// Every thread has its own arena, a list of large blocks from which aligned
+// buffers are taken by moving a pointer. Blocks are reserved from the system
+// without touching them, so with the default first-touch policy their pages
+// are placed on the NUMA node of the thread using them. Buffers are released
+// all at once by reset(), e.g. at the end of a time step, or in LIFO order
+// by arena::scope.
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct arena_options {
+    // size of the blocks reserved from the system
+    std::size_t block_size = std::size_t{64} << 20;
+    // back the blocks with transparent huge pages where supported
+    bool huge_pages = false;
+};
+
+struct arena_stats {
+    std::size_t used = 0;       // bytes handed out now
+    std::size_t reserved = 0;   // bytes reserved from the system
+    std::size_t high_water = 0; // largest value of used since creation
+};
+
+std::ostream& operator<<(std::ostream& s, const arena_stats& stats);
+
+class arena {
+public:
+    static constexpr std::size_t default_alignment = 64;
+
+    explicit arena(arena_options options = {});
+    ~arena();
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment = default_alignment);
+
+    // Releases all buffers, keeps the blocks for reuse
+    void reset();
+
+    arena_stats stats() const;
+
+    // Releases everything allocated during its lifetime on destruction
+    class scope {
+    public:
+        explicit scope(arena& a) : arena_(a), block_(a.current_), offset_(a.offset_) {}
+        ~scope() { arena_.rewind(block_, offset_); }
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        arena& arena_;
+        std::size_t block_;
+        std::size_t offset_;
+    };
+
+private:
+    struct block {
+        std::byte* data;
+        std::size_t size;
+    };
+
+    void rewind(std::size_t block, std::size_t offset);
+
+    arena_options options_;
+    std::vector<block> blocks_;
+    std::size_t current_ = 0;
+    std::size_t offset_ = 0;
+    // total size of the blocks before the current one
+    std::size_t base_ = 0;
+    std::size_t high_water_ = 0;
+};
+
+// Options used for thread arenas created after the call
+void set_thread_arena_options(const arena_options& options);
+
+// Arena of the calling thread, created on first use
+arena& thread_arena();
+
+// Sum of the statistics of all live thread arenas. Like reset_thread_arenas,
+// must not be called while other threads evaluate expressions.
+arena_stats thread_arena_stats();
+
+// Resets the arenas of all threads, e.g. between time steps
+void reset_thread_arenas();
+
+////////////////////////////////////////////////////////////////////////////////
+
+// n default constructed elements in the thread arena, released at the end of
+// the enclosing scope
+template <typename T>
+class temp_buffer {
+public:
+    explicit temp_buffer(std::size_t n, arena& a = thread_arena())
+        : scope_(a)
+        , data_(static_cast<T*>(a.allocate(n * sizeof(T), alignof(T) > arena::default_alignment ? alignof(T) : arena::default_alignment)))
+        , size_(n)
+    {
+        std::uninitialized_default_construct_n(data_, n);
+    }
+
+    ~temp_buffer() {
+        std::destroy_n(data_, size_);
+    }
+
+    temp_buffer(const temp_buffer&) = delete;
+    temp_buffer& operator=(const temp_buffer&) = delete;
+
+    T& operator[](std::size_t i) { return data_[i]; }
+    const T& operator[](std::size_t i) const { return data_[i]; }
+
+    std::size_t size() const { return size_; }
+    T* data() { return data_; }
+    T* begin() { return data_; }
+    T* end() { return data_ + size_; }
+
+private:
+    arena::scope scope_;
+    T* data_;
+    std::size_t size_;
+};
+
+// n uninitialized elements in the thread arena, valid until the arena is reset
+template <typename T>
+    requires std::is_trivially_destructible_v<T>
+std::span<T> allocate_temp(std::size_t n, arena& a = thread_arena()) {
+    constexpr std::size_t alignment = alignof(T) > arena::default_alignment ? alignof(T) : arena::default_alignment;
+    return {static_cast<T*>(a.allocate(n * sizeof(T), alignment)), n};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
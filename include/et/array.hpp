@@ -0,0 +1,641 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "expr.hpp"
+#include "arena.hpp"
+#include "cost.hpp"
+#include "fold.hpp"
+#include "placeholders.hpp"
+#include "profile.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+// true if the (sub)expression has the same value for every element
+template <typename T>
+inline constexpr bool is_invariant = !Field<T>;
+
+template <typename Arg>
+inline constexpr bool is_invariant<expr<Arg>> = is_invariant<std::remove_cvref_t<Arg>>;
+
+template <typename Op, typename Arg1, typename... Args>
+inline constexpr bool is_invariant<expr<Op, Arg1, Args...>> =
+    is_invariant<std::remove_cvref_t<Arg1>> && (is_invariant<std::remove_cvref_t<Args>> && ...);
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace tr {
+
+// Replaces every largest subexpression that does not depend on the element
+// index by its value. Used with transform_matching.
+struct hoist_invariants {
+    template <typename Op, typename Arg1, typename... Args>
+        requires et::detail::is_invariant<expr<Op, Arg1, Args...>>
+    constexpr auto operator()(const expr<Op, Arg1, Args...>& e) const {
+        return et::detail::copy(evaluate(e));
+    }
+};
+
+} // namespace tr
+
+template <typename E>
+constexpr decltype(auto) hoist_invariants(const E& e) {
+    return transform_matching(e, tr::hoist_invariants{});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename Arg>
+    requires (!Expr<Arg>)
+constexpr decltype(auto) evaluate_at(Arg&& arg, std::size_t i) {
+    if constexpr (Field<Arg>) {
+        // fields that store elements in another form convert them in load
+        if constexpr (requires { arg.load(i); }) {
+            return arg.load(i);
+        }
+        else {
+            return arg[i];
+        }
+    }
+    else {
+        return std::forward<Arg>(arg);
+    }
+}
+
+template<typename Arg>
+constexpr decltype(auto) evaluate_at(const expr<Arg> &e, std::size_t i) {
+    return evaluate_at(e.arg, i);
+}
+
+template<typename Op, typename Arg1>
+constexpr decltype(auto) evaluate_at(const expr<Op, Arg1> &e, std::size_t i) {
+    return e.op(evaluate_at(e.arg1, i));
+}
+
+template<typename Op, typename Arg1, typename Arg2>
+constexpr decltype(auto) evaluate_at(const expr<Op, Arg1, Arg2> &e, std::size_t i) {
+    return e.op(evaluate_at(e.arg1, i), evaluate_at(e.arg2, i));
+}
+
+template<typename Op, typename Arg1, typename Arg2, typename Arg3>
+constexpr decltype(auto) evaluate_at(const expr<Op, Arg1, Arg2, Arg3> &e, std::size_t i) {
+    return e.op(evaluate_at(e.arg1, i), evaluate_at(e.arg2, i), evaluate_at(e.arg3, i));
+}
+
+template<typename E>
+using element_type_t = std::remove_cvref_t<decltype(evaluate_at(std::declval<const E&>(), std::size_t{}))>;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Field that stores its elements contiguously and exposes them through std::data
+template <typename T>
+concept ContiguousField = Field<T> && requires (T& t) {
+    { std::data(t) } -> std::convertible_to<const field_element_t<T>*>;
+};
+
+// Field viewed with an index offset, element i is field[i + offset]. The
+// caller makes sure that the shifted indices stay inside the underlying
+// storage, e.g. by shifting a span over the interior of an array with ghost
+// cells. Elements are indexed through std::data, the shifted indices may be
+// outside the field itself.
+template <ContiguousField F>
+struct shifted {
+    F field;
+    std::ptrdiff_t offset;
+
+    constexpr decltype(auto) operator[](std::size_t i) const {
+        return std::data(field)[static_cast<std::ptrdiff_t>(i) + offset];
+    }
+
+    constexpr std::size_t size() const {
+        return std::size(field);
+    }
+};
+
+template <ContiguousField F>
+constexpr auto shift(F&& field, std::ptrdiff_t offset) {
+    return expr<shifted<F>>{{std::forward<F>(field), offset}};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Number of elements in the fields referenced by the expression, 0 if there are none.
+// All fields must have the same size.
+template <typename E>
+constexpr std::size_t extent(const E& e) {
+    std::size_t n = 0;
+    bool found = false;
+    auto visit = [&] <typename T> (const T& t) {
+        if constexpr (Field<T>) {
+            assert(!found || std::size(t) == n);
+            n = std::size(t);
+            found = true;
+        }
+    };
+    std::apply([&] (const auto&... t) { (visit(t), ...); }, tr::terminals{}(e));
+    return n;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+// memory occupied by the elements of a field
+struct memory_range {
+    std::uintptr_t begin = 0;
+    std::uintptr_t end = 0;
+
+    friend constexpr bool overlap(const memory_range& a, const memory_range& b) {
+        return a.begin < b.end && b.begin < a.end;
+    }
+
+    friend constexpr bool operator==(const memory_range&, const memory_range&) = default;
+};
+
+// elements are addressable as references
+template <typename T>
+inline constexpr bool has_element_references = std::is_lvalue_reference_v<decltype(std::declval<const T&>()[std::size_t{}])>;
+
+// the memory of the elements is known: fields with std::data, with
+// references to elements, or providing memory_bounds() when the storage is
+// neither (e.g. separate arrays of components)
+template <typename T>
+concept HasMemoryRange = Field<T> && (requires (const T& t) { std::data(t); }
+    || has_element_references<T> || requires (const T& t) { t.memory_bounds(); });
+
+template <Field T>
+memory_range range_of(const T& t) {
+    const std::size_t n = std::size(t);
+    if constexpr (requires { t.memory_bounds(); }) {
+        const auto [begin, end] = t.memory_bounds();
+        return {reinterpret_cast<std::uintptr_t>(begin), reinterpret_cast<std::uintptr_t>(end)};
+    }
+    else if constexpr (requires { std::data(t); }) {
+        return {reinterpret_cast<std::uintptr_t>(std::data(t)),
+                reinterpret_cast<std::uintptr_t>(std::data(t) + n)};
+    }
+    else if constexpr (has_element_references<T>) {
+        if (n > 0) {
+            return {reinterpret_cast<std::uintptr_t>(std::addressof(t[0])),
+                    reinterpret_cast<std::uintptr_t>(std::addressof(t[n - 1]) + 1)};
+        }
+    }
+    return {reinterpret_cast<std::uintptr_t>(std::addressof(t)),
+            reinterpret_cast<std::uintptr_t>(std::addressof(t) + 1)};
+}
+
+// type of the stored words, void if not known
+template <typename T>
+constexpr auto storage_type() {
+    if constexpr (requires (const T& t) { std::data(t); }) {
+        return std::type_identity<std::remove_cvref_t<decltype(*std::data(std::declval<const T&>()))>>{};
+    }
+    else if constexpr (has_element_references<T>) {
+        return std::type_identity<field_element_t<T>>{};
+    }
+    else {
+        return std::type_identity<void>{};
+    }
+}
+
+template <typename T>
+using storage_type_t = typename decltype(storage_type<T>())::type;
+
+// true if a terminal of type T can read the memory of Dst: both have known
+// memory, storing the same type of words
+template <typename Dst, typename T>
+inline constexpr bool may_alias = [] {
+    if constexpr (HasMemoryRange<T> && HasMemoryRange<Dst>) {
+        using A = storage_type_t<Dst>;
+        using B = storage_type_t<T>;
+        return std::is_void_v<A> || std::is_void_v<B> || std::is_same_v<A, B>;
+    }
+    else {
+        return false;
+    }
+}();
+
+// true if a broadcast terminal of type T, e.g. a reference to an element
+// of dst, can be stored in the memory of Dst
+template <typename Dst, typename T>
+inline constexpr bool may_alias_scalar = [] {
+    if constexpr (HasMemoryRange<Dst> && !Field<T> && !Expr<T> && !std::is_empty_v<T>) {
+        using A = storage_type_t<Dst>;
+        return std::is_void_v<A> || std::is_same_v<A, T>;
+    }
+    else {
+        return false;
+    }
+}();
+
+// terminal stored in an expression as Stored: broadcast terminals held by
+// value are copies, only references can point into dst
+template <typename Dst, typename Stored>
+inline constexpr bool may_alias_stored = may_alias<Dst, std::remove_cvref_t<Stored>>
+    || (std::is_lvalue_reference_v<Stored> && may_alias_scalar<Dst, std::remove_cvref_t<Stored>>);
+
+template <typename Dst, typename Arg>
+inline constexpr bool may_alias<Dst, expr<Arg>> = may_alias_stored<Dst, Arg>;
+
+template <typename Dst, typename Op, typename Arg1, typename... Args>
+inline constexpr bool may_alias<Dst, expr<Op, Arg1, Args...>> =
+    may_alias_stored<Dst, Arg1> || (may_alias_stored<Dst, Args> || ...);
+
+// element i of a terminal of type T can be located relative to element i of
+// Dst by comparing addresses
+template <typename Dst, typename T>
+inline constexpr bool is_addressable_alias = has_element_references<Dst> && has_element_references<T>
+    && std::is_same_v<field_element_t<T>, field_element_t<Dst>>;
+
+// type of the values of the elements of a field, e.g. of temporaries
+template <Field T>
+using field_value_t = std::remove_cvref_t<decltype(evaluate_at(std::declval<const T&>(), std::size_t{}))>;
+
+enum class assign_strategy {
+    forward,     // in place, element i reads dst only at indices >= i
+    backward,    // in place from the end, element i reads dst only at indices <= i
+    line_buffer, // results are written back with a delay, once nobody reads the old values
+    temporary,   // evaluated into a separate buffer and copied
+};
+
+struct assign_plan {
+    assign_strategy strategy = assign_strategy::forward;
+    // for line_buffer, largest distance to an element of dst read behind the current one
+    std::size_t delay = 0;
+};
+
+// largest line buffer kept instead of a full temporary, should stay in cache
+inline constexpr std::size_t max_line_buffer_bytes = 64 * 1024;
+
+// Picks the cheapest correct way to evaluate e into dst. Terminals that
+// overlap dst are expressed as dst shifted by a constant number of elements,
+// overlaps that can not be expressed this way need a full temporary.
+template <typename Dst, typename E>
+assign_plan plan_assign(const Dst& dst, const E& e) {
+    using T = field_element_t<Dst>;
+    if constexpr (!may_alias<Dst, E>) {
+        return {};
+    }
+    else {
+        const std::size_t n = std::size(dst);
+        if (n == 0) {
+            return {};
+        }
+        const memory_range out = range_of(dst);
+        std::ptrdiff_t min_shift = 0;
+        std::ptrdiff_t max_shift = 0;
+        bool shifted_only = true;
+
+        auto visit = [&] <typename U> (const U& t) {
+            if constexpr (may_alias<Dst, U>) {
+                const memory_range in = range_of(t);
+                if (!overlap(in, out)) {
+                    return;
+                }
+                if constexpr (is_addressable_alias<Dst, U>) {
+                    if (std::size(t) != n) {
+                        shifted_only = false;
+                        return;
+                    }
+                    // addresses of the first and last elements give the shift if
+                    // both fields are contiguous with the same stride
+                    auto diff = [&] (std::size_t i) {
+                        return static_cast<std::ptrdiff_t>(reinterpret_cast<std::uintptr_t>(std::addressof(t[i])) -
+                                                           reinterpret_cast<std::uintptr_t>(std::addressof(dst[i])));
+                    };
+                    const std::ptrdiff_t d = diff(0);
+                    const bool linear = out.end - out.begin == n * sizeof(T) && in.end - in.begin == n * sizeof(T);
+                    if (!linear || d != diff(n - 1) || d % static_cast<std::ptrdiff_t>(sizeof(T)) != 0) {
+                        shifted_only = false;
+                        return;
+                    }
+                    min_shift = std::min(min_shift, d / static_cast<std::ptrdiff_t>(sizeof(T)));
+                    max_shift = std::max(max_shift, d / static_cast<std::ptrdiff_t>(sizeof(T)));
+                }
+                else {
+                    // elements are not addressable: only the same view of the
+                    // same memory is known to read element i for element i
+                    if (!std::is_same_v<U, Dst> || in != out || std::size(t) != n) {
+                        shifted_only = false;
+                    }
+                }
+            }
+            else if constexpr (may_alias_scalar<Dst, U>) {
+                // a broadcast value read from dst changes once its element is written
+                const auto begin = reinterpret_cast<std::uintptr_t>(std::addressof(t));
+                if (overlap(memory_range{begin, begin + sizeof(U)}, out)) {
+                    shifted_only = false;
+                }
+            }
+        };
+        std::apply([&] (const auto&... t) { (visit(t), ...); }, tr::terminals{}(e));
+
+        if (!shifted_only) {
+            return {assign_strategy::temporary};
+        }
+        if (min_shift == 0) {
+            return {};
+        }
+        if (max_shift == 0) {
+            return {assign_strategy::backward};
+        }
+        const auto delay = static_cast<std::size_t>(-min_shift);
+        if (delay < n && (delay + 1) * sizeof(T) <= max_line_buffer_bytes) {
+            return {assign_strategy::line_buffer, delay};
+        }
+        return {assign_strategy::temporary};
+    }
+}
+
+template <typename Dst, typename E>
+constexpr void assign_loop(Dst& dst, const E& e, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        dst[i] = evaluate_at(e, i);
+    }
+}
+
+template <typename Dst, typename E>
+constexpr void assign_backward_loop(Dst& dst, const E& e, std::size_t n) {
+    for (std::size_t i = n; i-- > 0;) {
+        dst[i] = evaluate_at(e, i);
+    }
+}
+
+// Element i may read dst[i - delay] at the latest, so its result is stored
+// in a ring of delay + 1 values and written back delay iterations later.
+template <typename Dst, typename E>
+void assign_line_buffer_loop(Dst& dst, const E& e, std::size_t n, std::size_t delay) {
+    temp_buffer<field_value_t<Dst>> ring(delay + 1);
+    std::size_t slot = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        ring[slot] = evaluate_at(e, i);
+        slot = slot == delay ? 0 : slot + 1;
+        // slot now holds the oldest result, the one of element i - delay
+        if (i >= delay) {
+            dst[i - delay] = std::move(ring[slot]);
+        }
+    }
+    for (std::size_t i = n - delay; i < n; ++i) {
+        slot = slot == delay ? 0 : slot + 1;
+        dst[i] = std::move(ring[slot]);
+    }
+}
+
+template <typename Dst, typename Tmp, typename E>
+constexpr void assign_via(Dst& dst, Tmp& tmp, const E& e, std::size_t n) {
+    assign_loop(tmp, e, n);
+    for (std::size_t i = 0; i < n; ++i) {
+        dst[i] = std::move(tmp[i]);
+    }
+}
+
+template <typename Dst, typename E>
+constexpr void assign_dispatch(Dst& dst, const E& e, std::size_t n) {
+    if constexpr (may_alias<std::remove_cvref_t<Dst>, E>) {
+        if (std::is_constant_evaluated()) {
+            // addresses can not be compared during constant evaluation
+            std::vector<field_value_t<std::remove_cvref_t<Dst>>> tmp(n);
+            assign_via(dst, tmp, e, n);
+            return;
+        }
+        const assign_plan plan = plan_assign(dst, e);
+        switch (plan.strategy) {
+        case assign_strategy::forward:
+            assign_loop(dst, e, n);
+            break;
+        case assign_strategy::backward:
+            assign_backward_loop(dst, e, n);
+            break;
+        case assign_strategy::line_buffer:
+            assign_line_buffer_loop(dst, e, n, plan.delay);
+            break;
+        case assign_strategy::temporary: {
+            temp_buffer<field_value_t<std::remove_cvref_t<Dst>>> tmp(n);
+            assign_via(dst, tmp, e, n);
+            break;
+        }
+        }
+    }
+    else {
+        assign_loop(dst, e, n);
+    }
+}
+
+template <typename E, typename T, typename Op>
+constexpr T reduce_loop(const E& e, T init, Op& op, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        init = op(std::move(init), evaluate_at(e, i));
+    }
+    return init;
+}
+
+// Runs f, recording its wall time in stats (eval_stats or profile::entry)
+template <typename Stats, typename F>
+decltype(auto) timed(Stats& stats, const cost& per_element, std::size_t n, F&& f) {
+    struct guard {
+        Stats& stats;
+        const cost& per_element;
+        std::size_t n;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ~guard() {
+            stats.add(per_element, n, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+    };
+    guard g{stats, per_element, n};
+    return std::forward<F>(f)();
+}
+
+// Runs f, recording it in the profile registry as a kernel of the given
+// kind evaluating E when ET_PROFILE is defined
+template <typename Kind, typename E, typename F>
+decltype(auto) profiled(const cost& per_element, std::size_t n, F&& f) {
+#ifdef ET_PROFILE
+    return timed(profile::kernel_entry<Kind, E>(), per_element, n, std::forward<F>(f));
+#else
+    (void)per_element;
+    (void)n;
+    return std::forward<F>(f)();
+#endif
+}
+
+} // namespace detail
+
+template <Field Dst, typename E>
+constexpr void assign(Dst&& dst, const E& e) {
+    const std::size_t n = std::size(dst);
+    assert(extent(e) == n || extent(e) == 0);
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+#ifdef ET_PROFILE
+    if (!std::is_constant_evaluated()) {
+        constexpr cost c = assign_cost_v<std::remove_cvref_t<Dst>, std::remove_cvref_t<decltype(h)>>;
+        detail::timed(profile::kernel_entry<profile::assign_kernel, E>(), c, n, [&] { detail::assign_dispatch(dst, h, n); });
+        return;
+    }
+#endif
+    detail::assign_dispatch(dst, h, n);
+}
+
+// Same as above, accumulating time and per-element cost of the evaluation
+// in stats
+template <Field Dst, typename E>
+void assign(Dst&& dst, const E& e, eval_stats& stats) {
+    const std::size_t n = std::size(dst);
+    assert(extent(e) == n || extent(e) == 0);
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+    constexpr cost c = assign_cost_v<std::remove_cvref_t<Dst>, std::remove_cvref_t<decltype(h)>>;
+    detail::timed(stats, c, n, [&] { detail::assign_dispatch(dst, h, n); });
+}
+
+// Evaluates the expression into a buffer from the thread arena. The result
+// is a field that can be used in further expressions until the arena is reset.
+template <typename E>
+std::span<const element_type_t<E>> eval_to_temp(const E& e) {
+    const std::size_t n = extent(e);
+    std::span<element_type_t<E>> tmp = allocate_temp<element_type_t<E>>(n);
+    std::uninitialized_default_construct(tmp.begin(), tmp.end());
+    assign(tmp, e);
+    return tmp;
+}
+
+template <typename E, typename T, typename Op = op::plus>
+constexpr T reduce(const E& e, T init, Op op = {}) {
+    const std::size_t n = extent(e);
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+#ifdef ET_PROFILE
+    if (!std::is_constant_evaluated()) {
+        constexpr cost c = cost_v<std::remove_cvref_t<decltype(h)>> + apply_cost_v<Op, detail::shape_t<T>, detail::shape_t<decltype(h)>>;
+        return detail::timed(profile::kernel_entry<profile::reduce_kernel, E>(), c, n, [&] { return detail::reduce_loop(h, std::move(init), op, n); });
+    }
+#endif
+    return detail::reduce_loop(h, std::move(init), op, n);
+}
+
+template <typename E, typename T, typename Op>
+T reduce(const E& e, T init, Op op, eval_stats& stats) {
+    const std::size_t n = extent(e);
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+    constexpr cost c = cost_v<std::remove_cvref_t<decltype(h)>> + apply_cost_v<Op, detail::shape_t<T>, detail::shape_t<decltype(h)>>;
+    return detail::timed(stats, c, n, [&] { return detail::reduce_loop(h, std::move(init), op, n); });
+}
+
+template <typename E>
+constexpr auto sum(const E& e) {
+    return reduce(e, element_type_t<E>{});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+template <typename Dst, typename E, std::size_t... k>
+constexpr void assign_all_loop(Dst& dst, const E& e, std::size_t n, std::index_sequence<k...>) {
+    for (std::size_t i = 0; i < n; ++i) {
+        // all outputs are computed before the first store, so loads and common
+        // subexpressions of different outputs can be shared
+        std::tuple values{evaluate_at(std::get<k>(e), i)...};
+        ((std::get<k>(dst)[i] = std::get<k>(std::move(values))), ...);
+    }
+}
+
+// evaluated into temporaries of type Buffer<value type> and copied
+template <template <typename> class Buffer, typename Dst, typename E, std::size_t... k>
+constexpr void assign_all_via(Dst& dst, const E& e, std::size_t n, std::index_sequence<k...> seq) {
+    std::tuple<Buffer<field_value_t<std::remove_cvref_t<std::tuple_element_t<k, Dst>>>>...> tmp(((void)k, n)...);
+    assign_all_loop(tmp, e, n, seq);
+    for (std::size_t i = 0; i < n; ++i) {
+        ((std::get<k>(dst)[i] = std::move(std::get<k>(tmp)[i])), ...);
+    }
+}
+
+// true if a terminal of any of the expressions can read the memory of Dst
+template <typename Dst, typename E, typename Seq>
+inline constexpr bool may_alias_any = false;
+
+template <typename Dst, typename E, std::size_t... j>
+inline constexpr bool may_alias_any<Dst, E, std::index_sequence<j...>> =
+    (may_alias<Dst, std::remove_cvref_t<std::tuple_element_t<j, E>>> || ...);
+
+// true if every output can be evaluated in place by one forward loop
+template <typename D, typename E, std::size_t... j>
+bool forward_for_all(const D& dst, const E& e, std::index_sequence<j...>) {
+    return ((plan_assign(dst, std::get<j>(e)).strategy == assign_strategy::forward) && ...);
+}
+
+// all outputs of an iteration are stored after all are evaluated, so every
+// destination may be read at indices >= i by every expression
+template <typename Dst, typename E, std::size_t... k>
+constexpr void assign_all_dispatch(Dst& dst, const E& e, std::size_t n, std::index_sequence<k...> seq) {
+    if constexpr ((may_alias_any<std::remove_cvref_t<std::tuple_element_t<k, Dst>>, E, std::index_sequence<k...>> || ...)) {
+        if (std::is_constant_evaluated()) {
+            assign_all_via<std::vector>(dst, e, n, seq);
+            return;
+        }
+        if (!(forward_for_all(std::get<k>(dst), e, seq) && ...)) {
+            assign_all_via<temp_buffer>(dst, e, n, seq);
+            return;
+        }
+    }
+    assign_all_loop(dst, e, n, seq);
+}
+
+template <typename Dst, typename E, std::size_t... k>
+constexpr void assign_all_impl(Dst& dst, const E& e, std::index_sequence<k...> seq) {
+    const std::size_t n = std::size(std::get<0>(dst));
+    assert(((std::size(std::get<k>(dst)) == n) && ...));
+    assert(((extent(std::get<k>(e)) == n || extent(std::get<k>(e)) == 0) && ...));
+
+    std::tuple<decltype(fold_constants(std::get<k>(e)))...> f{fold_constants(std::get<k>(e))...};
+    std::tuple<decltype(hoist_invariants(std::get<k>(f)))...> h{hoist_invariants(std::get<k>(f))...};
+#ifdef ET_PROFILE
+    if (!std::is_constant_evaluated()) {
+        constexpr cost c = (cost{} + ... + assign_cost_v<std::remove_cvref_t<std::tuple_element_t<k, Dst>>,
+                                                          std::remove_cvref_t<std::tuple_element_t<k, decltype(h)>>>);
+        timed(profile::kernel_entry<profile::assign_kernel, E>(), c, n, [&] { assign_all_dispatch(dst, h, n, seq); });
+        return;
+    }
+#endif
+    assign_all_dispatch(dst, h, n, seq);
+}
+
+} // namespace detail
+
+// Evaluates several expressions in one loop, e.g.
+//     assign_all(std::tie(p, T, c), std::tuple(e_p, e_T, e_c));
+template <Field... Dst, typename... E>
+    requires (sizeof...(Dst) == sizeof...(E) && sizeof...(E) > 0)
+constexpr void assign_all(std::tuple<Dst...> dst, const std::tuple<E...>& e) {
+    detail::assign_all_impl(dst, e, std::index_sequence_for<E...>{});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
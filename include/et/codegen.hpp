@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "array.hpp"
+#include "fold.hpp"
+#include "type_name.hpp"
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Ahead-of-time compilation of array assignments.
+//
+// lower<T>(e) writes the loop assigning e to a field of T as C++ source
+// calling the et::op kernels. Only the structure of e is part of the source:
+// fields and scalars are arguments of the generated function, so
+// expressions differing only in their values share the code. load() compiles
+// the source with the local compiler into a shared object, which is cached on
+// disk under the hash of the source, the et headers, the compiler and its
+// flags, and loaded with dlopen on later runs.
+//
+//     auto k = et::codegen::compile<double>(e);   // compiles or loads
+//     k(dst, e);                                 // native loop
+//
+// Lowered expressions consist of stateless operations, arithmetic scalars,
+// compile-time constants and fields with contiguous arithmetic storage.
+
+namespace et::codegen {
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct options {
+    // empty: $CXX, or c++
+    std::string compiler;
+    // add -march=native only with a cache that is not shared between
+    // machines, the objects may not run on other CPUs
+    std::string flags = "-std=c++20 -O3";
+    // empty: $ET_CACHE_DIR, $XDG_CACHE_HOME/et, ~/.cache/et, or a private
+    // directory under the temporary directory
+    std::filesystem::path cache_dir;
+    // empty: $ET_INCLUDE_DIR, or ET_CODEGEN_INCLUDE_DIR of the et build
+    std::filesystem::path include_dir;
+};
+
+// Generated translation unit defining
+//     extern "C" void et_kernel(void* dst, const void* const* args, std::size_t n)
+struct source {
+    std::string text;
+    // hash of the text, identifies the structure of the expression
+    std::uint64_t hash;
+};
+
+using entry_point = void (*)(void* dst, const void* const* args, std::size_t n);
+
+// Returns the compiled source, from the process or disk cache if present.
+// Throws std::runtime_error if the source does not compile or load.
+entry_point load(const source& src, const options& opt = {});
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+enum class terminal_kind { constant, field, scalar, unsupported };
+
+template <typename T>
+constexpr terminal_kind kind_of() {
+    if constexpr (is_constant_v<T> && requires { { T::value } -> std::convertible_to<long double>; }) {
+        return terminal_kind::constant;
+    }
+    else if constexpr (Field<T>) {
+        if constexpr (std::is_arithmetic_v<field_element_t<T>> && requires (const T& f) {
+                          { std::data(f) } -> std::convertible_to<const field_element_t<T>*>;
+                      }) {
+            return terminal_kind::field;
+        }
+        else {
+            return terminal_kind::unsupported;
+        }
+    }
+    else if constexpr (std::is_arithmetic_v<T>) {
+        return terminal_kind::scalar;
+    }
+    else {
+        return terminal_kind::unsupported;
+    }
+}
+
+template <typename T>
+inline constexpr terminal_kind terminal_kind_v = kind_of<T>();
+
+// character loop, std::string_view::find is not a constant expression with
+// GCC's -fsanitize=undefined
+constexpr bool contains(std::string_view s, std::string_view part) {
+    for (std::size_t i = 0; i + part.size() <= s.size(); ++i) {
+        std::size_t k = 0;
+        while (k < part.size() && s[i + k] == part[k]) {
+            ++k;
+        }
+        if (k == part.size()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// an operation can be named in the generated source if it is a default
+// constructible type with external linkage
+template <typename Op>
+inline constexpr bool is_lowerable_op = std::is_empty_v<Op> && std::is_default_constructible_v<Op>
+    && !contains(get_type_name<Op>(), "lambda") && !contains(get_type_name<Op>(), "anonymous");
+
+// number of arguments passed to the generated function
+template <typename T>
+inline constexpr std::size_t argument_count = terminal_kind_v<T> == terminal_kind::field
+    || terminal_kind_v<T> == terminal_kind::scalar;
+
+template <typename Op, typename... Args>
+inline constexpr std::size_t argument_count<expr<Op, Args...>> =
+    (argument_count<std::remove_cvref_t<Args>> + ... + 0);
+
+template <typename Arg>
+inline constexpr std::size_t argument_count<expr<Arg>> = argument_count<std::remove_cvref_t<Arg>>;
+
+template <typename T>
+std::string literal(T v) {
+    std::ostringstream s;
+    s << "static_cast<" << get_type_name<T>() << ">(";
+    if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(v)) {
+            s << "std::numeric_limits<" << get_type_name<T>() << ">::quiet_NaN()";
+        }
+        else if (std::isinf(v)) {
+            s << (v < 0 ? "-" : "") << "std::numeric_limits<" << get_type_name<T>() << ">::infinity()";
+        }
+        else {
+            // exact
+            s << std::hexfloat << v;
+        }
+    }
+    else if constexpr (std::is_same_v<T, bool>) {
+        s << (v ? "true" : "false");
+    }
+    else {
+        s << +v;
+    }
+    s << ")";
+    return s.str();
+}
+
+struct source_writer {
+    std::string loads;
+    std::size_t args = 0;
+
+    // declares the next argument, returns its name
+    std::string argument(std::string_view type, bool field) {
+        std::string name = "a" + std::to_string(args);
+        if (field) {
+            loads += "    const auto* " + name + " = static_cast<const " + std::string(type) + "*>(args[" + std::to_string(args) + "]);\n";
+        }
+        else {
+            loads += "    const auto " + name + " = *static_cast<const " + std::string(type) + "*>(args[" + std::to_string(args) + "]);\n";
+        }
+        ++args;
+        return name;
+    }
+};
+
+template <typename T>
+std::string lower_node(source_writer& w, const T& /*t*/) {
+    constexpr terminal_kind kind = terminal_kind_v<T>;
+    if constexpr (kind == terminal_kind::constant) {
+        return literal(T::value);
+    }
+    else if constexpr (kind == terminal_kind::field) {
+        return w.argument(get_type_name<field_element_t<T>>(), true) + "[i]";
+    }
+    else if constexpr (kind == terminal_kind::scalar) {
+        return w.argument(get_type_name<T>(), false);
+    }
+    else {
+        static_assert(false, "Terminal can not be lowered to C++ source");
+    }
+}
+
+template <typename Arg>
+std::string lower_node(source_writer& w, const expr<Arg>& e) {
+    return lower_node(w, e.arg);
+}
+
+template <typename Op>
+std::string op_call() {
+    static_assert(is_lowerable_op<Op>, "Operation can not be lowered to C++ source");
+    return std::string(get_type_name<Op>()) + "{}(";
+}
+
+template <typename Op, typename Arg1>
+std::string lower_node(source_writer& w, const expr<Op, Arg1>& e) {
+    std::string s = op_call<std::remove_cvref_t<Op>>();
+    s += lower_node(w, e.arg1);
+    return s + ")";
+}
+
+template <typename Op, typename Arg1, typename Arg2>
+std::string lower_node(source_writer& w, const expr<Op, Arg1, Arg2>& e) {
+    std::string s = op_call<std::remove_cvref_t<Op>>();
+    s += lower_node(w, e.arg1);
+    s += ", ";
+    s += lower_node(w, e.arg2);
+    return s + ")";
+}
+
+template <typename Op, typename Arg1, typename Arg2, typename Arg3>
+std::string lower_node(source_writer& w, const expr<Op, Arg1, Arg2, Arg3>& e) {
+    std::string s = op_call<std::remove_cvref_t<Op>>();
+    s += lower_node(w, e.arg1);
+    s += ", ";
+    s += lower_node(w, e.arg2);
+    s += ", ";
+    s += lower_node(w, e.arg3);
+    return s + ")";
+}
+
+// stores the arguments in the order lower_node declares them
+template <typename T>
+void collect_arguments(const T& t, const void**& out) {
+    constexpr terminal_kind kind = terminal_kind_v<T>;
+    if constexpr (kind == terminal_kind::field) {
+        *out++ = std::data(t);
+    }
+    else if constexpr (kind == terminal_kind::scalar) {
+        *out++ = &t;
+    }
+}
+
+template <typename Arg>
+void collect_arguments(const expr<Arg>& e, const void**& out) {
+    collect_arguments(e.arg, out);
+}
+
+template <typename Op, typename... Args>
+    requires (sizeof...(Args) > 0)
+void collect_arguments(const expr<Op, Args...>& e, const void**& out) {
+    if constexpr (sizeof...(Args) >= 1) {
+        collect_arguments(e.arg1, out);
+    }
+    if constexpr (sizeof...(Args) >= 2) {
+        collect_arguments(e.arg2, out);
+    }
+    if constexpr (sizeof...(Args) >= 3) {
+        collect_arguments(e.arg3, out);
+    }
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Source of the loop assigning e to a field of T
+template <typename T, typename E>
+source lower(const E& e) {
+    static_assert(std::is_arithmetic_v<T>, "Only fields of arithmetic types are supported");
+
+    decltype(auto) f = fold_constants(e);
+    detail::source_writer w;
+    std::string value = detail::lower_node(w, f);
+
+    std::string text = "// generated by et::codegen\n"
+        "#include \"et/math.hpp\"\n"
+        "#include \"et/precision.hpp\"\n"
+        "\n"
+        "#include <cstddef>\n"
+        "#include <limits>\n"
+        "\n"
+        "extern \"C\" void et_kernel(void* dst_, const void* const* args, std::size_t n)\n"
+        "{\n";
+    text += "    auto* dst = static_cast<" + std::string(get_type_name<T>()) + "*>(dst_);\n";
+    text += w.loads;
+    text += "    (void)args;\n"
+        "    for (std::size_t i = 0; i < n; ++i) {\n";
+    text += "        dst[i] = static_cast<" + std::string(get_type_name<T>()) + ">(" + value + ");\n";
+    text += "    }\n"
+        "}\n";
+
+    std::uint64_t hash = et::detail::hash_string(text);
+    return {std::move(text), hash};
+}
+
+// Compiled assignment of expressions of type E to fields of T. The
+// expression passed to the constructor provides only the structure, the one
+// passed to a call provides the values.
+template <typename T, typename E>
+class kernel {
+public:
+    // the compiled loop evaluates e with its invariants hoisted, like et::assign
+    explicit kernel(const E& e, const options& opt = {})
+        : entry_(load(lower<T>(hoist_invariants(fold_constants(e))), opt))
+    {
+    }
+
+    // The compiled loop runs forward in place; when dst overlaps the
+    // fields of e in a way that needs another order or a temporary, the
+    // assignment is left to et::assign.
+    void operator()(std::span<T> dst, const E& e) const {
+        assert(extent(e) == dst.size() || extent(e) == 0);
+
+        decltype(auto) f = fold_constants(e);
+        decltype(auto) h = hoist_invariants(f);
+        if (et::detail::plan_assign(dst, h).strategy != et::detail::assign_strategy::forward) {
+            et::assign(dst, e);
+            return;
+        }
+        std::array<const void*, detail::argument_count<std::remove_cvref_t<decltype(h)>> + 1> args{};
+        const void** out = args.data();
+        detail::collect_arguments(h, out);
+        constexpr cost c = assign_cost_v<std::span<T>, std::remove_cvref_t<decltype(h)>>;
+        et::detail::profiled<profile::assign_kernel, E>(c, dst.size(), [&] { entry_(dst.data(), args.data(), dst.size()); });
+    }
+
+private:
+    entry_point entry_;
+};
+
+template <typename T, typename E>
+kernel<T, E> compile(const E& e, const options& opt = {}) {
+    return kernel<T, E>(e, opt);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et::codegen
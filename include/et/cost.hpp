@@ -0,0 +1,338 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "expr.hpp"
+#include "math.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Operation count and memory traffic of one element of an array evaluation
+struct cost {
+    std::size_t add = 0;
+    std::size_t mul = 0;
+    std::size_t div = 0;
+    std::size_t sqrt = 0;
+    std::size_t transcendental = 0;
+    // operations that are not counted as flops (rounding, unknown functions)
+    std::size_t other = 0;
+
+    std::size_t bytes_loaded = 0;
+    std::size_t bytes_stored = 0;
+
+    constexpr std::size_t flops() const {
+        return add + mul + div + sqrt + transcendental;
+    }
+
+    constexpr std::size_t bytes() const {
+        return bytes_loaded + bytes_stored;
+    }
+
+    // arithmetic intensity, flop/byte
+    constexpr double intensity() const {
+        return bytes() == 0 ? 0.0 : static_cast<double>(flops()) / static_cast<double>(bytes());
+    }
+
+    constexpr cost& operator+=(const cost& rhs) {
+        add += rhs.add;
+        mul += rhs.mul;
+        div += rhs.div;
+        sqrt += rhs.sqrt;
+        transcendental += rhs.transcendental;
+        other += rhs.other;
+        bytes_loaded += rhs.bytes_loaded;
+        bytes_stored += rhs.bytes_stored;
+        return *this;
+    }
+
+    friend constexpr cost operator+(cost lhs, const cost& rhs) {
+        return lhs += rhs;
+    }
+
+    // n applications, e.g. of an element-wise operation to n components
+    friend constexpr cost operator*(cost c, std::size_t n) {
+        c.add *= n;
+        c.mul *= n;
+        c.div *= n;
+        c.sqrt *= n;
+        c.transcendental *= n;
+        c.other *= n;
+        c.bytes_loaded *= n;
+        c.bytes_stored *= n;
+        return c;
+    }
+
+    friend constexpr bool operator==(const cost&, const cost&) = default;
+};
+
+std::ostream& operator<<(std::ostream& s, const cost& c);
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Cost of a single application of an operation. Specialise for user operations.
+template <typename Op>
+inline constexpr cost op_cost_v = {.other = 1};
+
+template <> inline constexpr cost op_cost_v<op::plus> = {.add = 1};
+template <> inline constexpr cost op_cost_v<op::minus> = {.add = 1};
+template <> inline constexpr cost op_cost_v<op::negate> = {.add = 1};
+template <> inline constexpr cost op_cost_v<op::multiplies> = {.mul = 1};
+template <> inline constexpr cost op_cost_v<op::divides> = {.div = 1};
+template <> inline constexpr cost op_cost_v<op::modulus> = {.div = 1};
+
+template <> inline constexpr cost op_cost_v<op::logical_and> = {};
+template <> inline constexpr cost op_cost_v<op::logical_or> = {};
+template <> inline constexpr cost op_cost_v<op::logical_not> = {};
+template <> inline constexpr cost op_cost_v<op::bit_and> = {};
+template <> inline constexpr cost op_cost_v<op::bit_or> = {};
+template <> inline constexpr cost op_cost_v<op::bit_xor> = {};
+template <> inline constexpr cost op_cost_v<op::bit_not> = {};
+template <> inline constexpr cost op_cost_v<op::equal_to> = {};
+template <> inline constexpr cost op_cost_v<op::not_equal_to> = {};
+template <> inline constexpr cost op_cost_v<op::greater> = {};
+template <> inline constexpr cost op_cost_v<op::less> = {};
+template <> inline constexpr cost op_cost_v<op::greater_equal> = {};
+template <> inline constexpr cost op_cost_v<op::less_equal> = {};
+template <> inline constexpr cost op_cost_v<op::identity> = {};
+template <> inline constexpr cost op_cost_v<op::select> = {};
+
+template <> inline constexpr cost op_cost_v<op::abs> = {.add = 1};
+template <> inline constexpr cost op_cost_v<op::fabs> = {.add = 1};
+template <> inline constexpr cost op_cost_v<op::fmax> = {.add = 1};
+template <> inline constexpr cost op_cost_v<op::fmin> = {.add = 1};
+template <> inline constexpr cost op_cost_v<op::fdim> = {.add = 1};
+template <> inline constexpr cost op_cost_v<op::copysign> = {.add = 1};
+template <> inline constexpr cost op_cost_v<op::fma> = {.add = 1, .mul = 1};
+template <> inline constexpr cost op_cost_v<op::fmod> = {.div = 1};
+template <> inline constexpr cost op_cost_v<op::remainder> = {.div = 1};
+template <> inline constexpr cost op_cost_v<op::remquo> = {.div = 1};
+
+template <> inline constexpr cost op_cost_v<op::sqrt> = {.sqrt = 1};
+template <> inline constexpr cost op_cost_v<op::cbrt> = {.sqrt = 1};
+template <> inline constexpr cost op_cost_v<op::hypot> = {.sqrt = 1};
+
+template <> inline constexpr cost op_cost_v<op::exp> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::exp2> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::expm1> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::log> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::log10> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::log2> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::log1p> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::pow> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::sin> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::cos> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::tan> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::asin> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::acos> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::atan> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::atan2> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::sinh> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::cosh> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::tanh> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::asinh> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::acosh> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::atanh> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::erf> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::erfc> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::tgamma> = {.transcendental = 1};
+template <> inline constexpr cost op_cost_v<op::lgamma> = {.transcendental = 1};
+
+template <> inline constexpr cost op_cost_v<op::isfinite> = {};
+template <> inline constexpr cost op_cost_v<op::isinf> = {};
+template <> inline constexpr cost op_cost_v<op::isnan> = {};
+template <> inline constexpr cost op_cost_v<op::isnormal> = {};
+template <> inline constexpr cost op_cost_v<op::signbit> = {};
+
+namespace detail {
+
+// same sequence of multiplications as op::ipow
+template <int exp>
+constexpr cost ipow_cost() {
+    if constexpr (exp < 0) {
+        return ipow_cost<-exp>() + cost{.div = 1};
+    }
+    else if constexpr (exp <= 1) {
+        return {};
+    }
+    else {
+        return ipow_cost<exp / 2>() + cost{.mul = (exp & 1) ? 2u : 1u};
+    }
+}
+
+} // namespace detail
+
+template <int exp>
+inline constexpr cost op_cost_v<op::ipow<exp>> = detail::ipow_cost<exp>();
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Shapes of the values of an expression. Values with several components
+// (small vectors and tensors) keep their type, everything else is a scalar.
+
+struct scalar_shape {};
+
+namespace detail {
+
+template <typename T>
+inline constexpr std::size_t components_v = 1;
+
+template <typename T>
+    requires requires { T::components; }
+inline constexpr std::size_t components_v<T> = T::components;
+
+template <typename T>
+using shape_of_value_t = std::conditional_t<(components_v<T> > 1), T, scalar_shape>;
+
+template <typename T>
+struct field_value {
+    using type = field_element_t<T>;
+};
+
+template <typename T>
+    requires requires { typename T::value_type; }
+struct field_value<T> {
+    using type = typename T::value_type;
+};
+
+template <typename T>
+struct shape {
+    using type = shape_of_value_t<T>;
+};
+
+template <typename T>
+using shape_t = typename shape<std::remove_cvref_t<T>>::type;
+
+template <Field T>
+struct shape<T> {
+    using type = shape_of_value_t<typename field_value<T>::type>;
+};
+
+template <typename Arg>
+struct shape<expr<Arg>> {
+    using type = shape_t<Arg>;
+};
+
+// scalars stand in as double when an operation is applied to a tensor
+template <typename S>
+using shape_value_t = std::conditional_t<std::is_same_v<S, scalar_shape>, double, S>;
+
+// only operations on tensors are applied, the result of scalar operations is scalar
+template <typename Op, typename... Shapes>
+struct apply_shape {
+    using type = scalar_shape;
+};
+
+template <typename Op, typename... Shapes>
+    requires (!(std::is_same_v<Shapes, scalar_shape> && ...))
+        && std::invocable<const Op&, const shape_value_t<Shapes>&...>
+struct apply_shape<Op, Shapes...> {
+    using type = shape_of_value_t<std::remove_cvref_t<std::invoke_result_t<const Op&, const shape_value_t<Shapes>&...>>>;
+};
+
+template <typename Op, typename Arg1, typename... Args>
+struct shape<expr<Op, Arg1, Args...>> {
+    using type = typename apply_shape<Op, shape_t<Arg1>, shape_t<Args>...>::type;
+};
+
+} // namespace detail
+
+// Cost of applying Op to values of the shapes Shapes (scalar_shape or a small
+// tensor type): element-wise operations cost op_cost_v once per component of
+// the result. Specialise for operations whose cost depends on the shapes.
+template <typename Op, typename... Shapes>
+inline constexpr cost apply_cost_v =
+    op_cost_v<Op> * detail::components_v<typename detail::apply_shape<Op, Shapes...>::type>;
+
+// Cost of the operation at the root of an expression, without its arguments
+template <typename E>
+inline constexpr cost node_cost_v = {};
+
+template <typename Op, typename Arg1, typename... Args>
+inline constexpr cost node_cost_v<expr<Op, Arg1, Args...>> =
+    apply_cost_v<Op, detail::shape_t<Arg1>, detail::shape_t<Args>...>;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Per-element cost of evaluating an expression. Every field terminal is
+// counted as one load, repeated occurrences of the same field included.
+template <typename T>
+inline constexpr cost cost_v = {};
+
+namespace detail {
+
+// bytes of storage per element, fields that pack their elements provide storage_bytes
+template <Field T>
+constexpr std::size_t element_bytes() {
+    if constexpr (requires { T::storage_bytes; }) {
+        return T::storage_bytes;
+    }
+    else {
+        return sizeof(field_element_t<T>);
+    }
+}
+
+} // namespace detail
+
+template <Field T>
+inline constexpr cost cost_v<T> = {.bytes_loaded = detail::element_bytes<T>()};
+
+template <typename Arg>
+inline constexpr cost cost_v<expr<Arg>> = cost_v<std::remove_cvref_t<Arg>>;
+
+template <typename Op, typename Arg1, typename... Args>
+inline constexpr cost cost_v<expr<Op, Arg1, Args...>> =
+    ((node_cost_v<expr<Op, Arg1, Args...>> + cost_v<std::remove_cvref_t<Arg1>>) + ... + cost_v<std::remove_cvref_t<Args>>);
+
+// Per-element cost of assigning an expression to a field
+template <Field Dst, typename E>
+inline constexpr cost assign_cost_v = cost_v<E> + cost{.bytes_stored = detail::element_bytes<Dst>()};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Accumulated measurements of array evaluations. The rates are derived
+// from the totals, so evaluations of different cost can share the stats.
+struct eval_stats {
+    // cost of the last evaluation
+    cost per_element;
+    std::size_t calls = 0;
+    std::size_t elements = 0;
+    double seconds = 0.0;
+    double flops = 0.0;
+    double bytes = 0.0;
+
+    void add(const cost& c, std::size_t n, double t) {
+        per_element = c;
+        calls += 1;
+        elements += n;
+        seconds += t;
+        flops += static_cast<double>(c.flops()) * static_cast<double>(n);
+        bytes += static_cast<double>(c.bytes()) * static_cast<double>(n);
+    }
+
+    double gflops() const {
+        return seconds > 0.0 ? flops / seconds * 1e-9 : 0.0;
+    }
+
+    // GB/s
+    double bandwidth() const {
+        return seconds > 0.0 ? bytes / seconds * 1e-9 : 0.0;
+    }
+
+    double intensity() const {
+        return bytes > 0.0 ? flops / bytes : 0.0;
+    }
+};
+
+std::ostream& operator<<(std::ostream& s, const eval_stats& st);
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
@@ -5,9 +5,15 @@
 
 #include "expr.hpp"
 #include "math.hpp"
+#include "cost.hpp"
+#include "fold.hpp"
 
+#include <array>
+#include <cstddef>
+#include <tuple>
 #include <type_traits>
 #include <iostream>
+#include <utility>
 
 namespace autodiff {
 
@@ -28,6 +34,9 @@ auto var(T&& x) {
 
 } // namespace autodiff
 
+template <int i>
+inline constexpr et::cost et::op_cost_v<autodiff::op::var<i>> = {};
+
 namespace autodiff {
 
 struct unknown_type {};
@@ -39,7 +48,7 @@ inline unknown_type operator/(const unknown_type&, const unknown_type&);
 
 template<typename T>
 struct zero {
-    operator T() const {
+    constexpr operator T() const {
         return T{0};
     }
 };
@@ -52,7 +61,7 @@ std::ostream& operator<<(std::ostream& s, const zero<T>&)
 
 template<typename T>
 struct one {
-    operator T() const {
+    constexpr operator T() const {
         return T{1};
     }
 };
@@ -63,6 +72,16 @@ std::ostream& operator<<(std::ostream& s, const one<T>&)
     return s << "1";
 }
 
+} // namespace autodiff
+
+template<typename T>
+inline constexpr bool et::is_constant_v<autodiff::zero<T>> = true;
+
+template<typename T>
+inline constexpr bool et::is_constant_v<autodiff::one<T>> = true;
+
+namespace autodiff {
+
 template<typename T1, typename T2>
 using derivative_type = decltype (std::declval<T1>() / std::declval<T2>());
 
@@ -93,6 +112,21 @@ constexpr auto unary_function_derivative(const et::op::cos& /*fn*/, Arg&& arg) {
     return et::expr(et::op::negate{}, et::expr(et::op::sin{}, std::forward<Arg>(arg)));
 }
 
+template <typename Arg>
+constexpr auto unary_function_derivative(const et::op::exp& /*fn*/, Arg&& arg) {
+    return et::expr(et::op::exp{}, std::forward<Arg>(arg));
+}
+
+template <typename Arg>
+constexpr auto unary_function_derivative(const et::op::log& /*fn*/, Arg&& arg) {
+    return et::expr(et::op::ipow<-1>{}, std::forward<Arg>(arg));
+}
+
+template <typename Arg>
+constexpr auto unary_function_derivative(const et::op::sqrt& /*fn*/, Arg&& arg) {
+    return et::expr(et::op::divides{}, 0.5, et::expr(et::op::sqrt{}, std::forward<Arg>(arg)));
+}
+
 template <int i, typename V>
 struct xform_derivative {
 
@@ -126,7 +160,7 @@ struct xform_derivative {
     constexpr auto operator ()(const et::expr<Func, Arg>& e) const {
         auto d = xform_derivative{}(e.arg1);
         if constexpr(is_dependent<decltype(d)>){
-            return et::expr(et::op::multiplies{}, unary_function_derivative(e.op, e.arg1), d);
+            return et::expr(et::op::multiplies{}, unary_function_derivative(e.op, e.arg1), std::move(d));
         }
         else {
             return not_dependent{};
@@ -166,7 +200,7 @@ struct xform_derivative {
     constexpr auto operator ()(const et::expr<et::op::negate, Expr>& e) const {
         auto d = xform_derivative{}(e.arg1);
         if constexpr(is_dependent<decltype(d)>){
-            return et::expr(et::op::negate{}, d);
+            return et::expr(et::op::negate{}, std::move(d));
         }
         else {
             return not_dependent{};
@@ -358,4 +392,642 @@ constexpr auto transform_to_convergence(const E& e, Transform&& transform)
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+// Sums and products of terms that may be not_dependent
+
+template <typename A, typename B>
+constexpr auto add(const A& a, const B& b) {
+    if constexpr (is_dependent<A> && is_dependent<B>) {
+        return et::as_expr(a) + b;
+    }
+    else if constexpr (is_dependent<A>) {
+        return a;
+    }
+    else if constexpr (is_dependent<B>) {
+        return b;
+    }
+    else {
+        return not_dependent{};
+    }
+}
+
+template <typename A, typename B>
+constexpr auto sub(const A& a, const B& b) {
+    if constexpr (is_dependent<A> && is_dependent<B>) {
+        return et::as_expr(a) - b;
+    }
+    else if constexpr (is_dependent<A>) {
+        return a;
+    }
+    else if constexpr (is_dependent<B>) {
+        return - et::as_expr(b);
+    }
+    else {
+        return not_dependent{};
+    }
+}
+
+template <typename A>
+constexpr auto neg(const A& a) {
+    if constexpr (is_dependent<A>) {
+        return - et::as_expr(a);
+    }
+    else {
+        return not_dependent{};
+    }
+}
+
+template <typename A, typename B>
+constexpr auto mul(const A& a, const B& b) {
+    if constexpr (is_dependent<A> && is_dependent<B>) {
+        return et::as_expr(a) * b;
+    }
+    else {
+        return not_dependent{};
+    }
+}
+
+// value type of the first var<i> in E, double if there is none
+template <int i, typename E>
+struct var_type {
+    using type = void;
+};
+
+template <int i, typename T>
+struct var_type<i, et::expr<op::var<i>, T>> {
+    using type = std::remove_cvref_t<T>;
+};
+
+template <typename... Ts>
+struct first_non_void {
+    using type = void;
+};
+
+template <typename T, typename... Ts>
+struct first_non_void<T, Ts...> {
+    using type = std::conditional_t<std::is_void_v<T>, typename first_non_void<Ts...>::type, T>;
+};
+
+template <int i, typename Op, typename... Args>
+struct var_type<i, et::expr<Op, Args...>> {
+    using type = typename first_non_void<typename var_type<i, std::remove_cvref_t<Args>>::type...>::type;
+};
+
+template <int i, typename E>
+using var_type_t = std::conditional_t<std::is_void_v<typename var_type<i, E>::type>, double, typename var_type<i, E>::type>;
+
+} // namespace detail
+
+// Second derivative d2e/dvar<i>dvar<j>, built by the second order rules from
+// the first derivatives of the operands, so it consists of the same subtrees
+// as the first derivatives. Like xform_derivative, the result refers to the
+// terminals of the expression.
+template <int i, typename Vi, int j, typename Vj>
+struct xform_second_derivative {
+    using d_i = xform_derivative<i, Vi>;
+    using d_j = xform_derivative<j, Vj>;
+
+    template <typename T>
+    constexpr auto operator ()(const T& /* v */) const {
+        return not_dependent{};
+    }
+
+    template <typename Func>
+    constexpr auto operator ()(const et::expr<Func>& /*e*/) const {
+        return not_dependent{};
+    }
+
+    template <int k, typename T>
+    constexpr auto operator ()(const et::expr<op::var<k>, T>& /* v */) const {
+        return not_dependent{};
+    }
+
+    template <typename Func, typename Arg1, typename Arg2, typename... Args>
+    constexpr auto operator ()(const et::expr<Func, Arg1, Arg2, Args...>& /*e*/) const {
+        static_assert(false, "Can not take derivative of an unknown function");
+    }
+
+    // f(a)'' = f'(a) a_ij + f''(a) a_i a_j
+    template <typename Func, typename Arg>
+    constexpr auto operator ()(const et::expr<Func, Arg>& e) const {
+        auto a_i = d_i{}(e.arg1);
+        auto a_j = d_j{}(e.arg1);
+        if constexpr (is_dependent<decltype(a_i)> && is_dependent<decltype(a_j)>) {
+            auto df = unary_function_derivative(e.op, e.arg1);
+            // d_j(f'(a)) = f''(a) a_j
+            return detail::add(detail::mul(df, (*this)(e.arg1)), detail::mul(d_j{}(df), a_i));
+        }
+        else {
+            return not_dependent{};
+        }
+    }
+
+    template <typename Expr>
+    constexpr auto operator ()(const et::expr<et::op::identity, Expr>& e) const {
+        return (*this)(e.arg1);
+    }
+
+    template <typename Expr>
+    constexpr auto operator ()(const et::expr<et::op::negate, Expr>& e) const {
+        return detail::neg((*this)(e.arg1));
+    }
+
+    template <typename Expr>
+    constexpr auto operator ()(const et::expr<et::op::ipow<0>, Expr>& /*e*/) const {
+        return not_dependent{};
+    }
+
+    template <typename Expr>
+    constexpr auto operator ()(const et::expr<et::op::ipow<1>, Expr>& e) const {
+        return (*this)(e.arg1);
+    }
+
+    // (a^n)'' = n a^(n-1) a_ij + n (n-1) a^(n-2) a_i a_j
+    template <typename Expr, int exp>
+    constexpr auto operator ()(const et::expr<et::op::ipow<exp>, Expr>& e) const {
+        auto a = et::as_expr(e.arg1);
+        auto first = detail::mul(et::expr(exp) * ipow<exp - 1>(a), (*this)(e.arg1));
+        auto a_ij = detail::mul(d_i{}(e.arg1), d_j{}(e.arg1));
+        if constexpr (exp == 2) {
+            return detail::add(first, detail::mul(et::expr(exp * (exp - 1)), a_ij));
+        }
+        else {
+            return detail::add(first, detail::mul(et::expr(exp * (exp - 1)) * ipow<exp - 2>(a), a_ij));
+        }
+    }
+
+    template <typename LHS, typename RHS>
+    constexpr auto operator()(const et::expr<et::op::plus, LHS, RHS>& e) const {
+        return detail::add((*this)(e.arg1), (*this)(e.arg2));
+    }
+
+    template <typename LHS, typename RHS>
+    constexpr auto operator()(const et::expr<et::op::minus, LHS, RHS>& e) const {
+        return detail::sub((*this)(e.arg1), (*this)(e.arg2));
+    }
+
+    // (a b)'' = a_ij b + a_i b_j + a_j b_i + a b_ij
+    template <typename LHS, typename RHS>
+    constexpr auto operator()(const et::expr<et::op::multiplies, LHS, RHS>& e) const {
+        auto cross = detail::add(detail::mul(d_i{}(e.arg1), d_j{}(e.arg2)), detail::mul(d_j{}(e.arg1), d_i{}(e.arg2)));
+        auto outer = detail::add(detail::mul((*this)(e.arg1), e.arg2), detail::mul(e.arg1, (*this)(e.arg2)));
+        return detail::add(outer, cross);
+    }
+
+    // (a / b)'' = a_ij / b - (a_i b_j + a_j b_i + a b_ij) / b^2 + 2 a b_i b_j / b^3
+    template <typename LHS, typename RHS>
+    constexpr auto operator()(const et::expr<et::op::divides, LHS, RHS>& e) const {
+        auto b = et::as_expr(e.arg2);
+        auto b_i = d_i{}(e.arg2);
+        auto b_j = d_j{}(e.arg2);
+        auto a_ij = (*this)(e.arg1);
+        auto first = [&] {
+            if constexpr (is_dependent<decltype(a_ij)>) {
+                return et::as_expr(a_ij) / b;
+            }
+            else {
+                return not_dependent{};
+            }
+        }();
+        auto cross = detail::add(detail::add(detail::mul(d_i{}(e.arg1), b_j), detail::mul(d_j{}(e.arg1), b_i)),
+                                 detail::mul(e.arg1, (*this)(e.arg2)));
+        auto two_a_b_i_b_j = detail::mul(et::expr(2) * e.arg1, detail::mul(b_i, b_j));
+        return detail::add(detail::sub(first, detail::mul(cross, ipow<-2>(b))), detail::mul(two_a_b_i_b_j, ipow<-3>(b)));
+    }
+
+    template <typename Pred, typename LHS, typename RHS>
+    constexpr auto operator()(const et::expr<et::op::select, Pred, LHS, RHS>& e) const {
+        auto h2 = (*this)(e.arg2);
+        auto h3 = (*this)(e.arg3);
+        if constexpr (is_dependent<decltype(h2)> || is_dependent<decltype(h3)>) {
+            return et::expr(et::op::select{}, e.arg1, std::move(h2), std::move(h3));
+        }
+        else {
+            return not_dependent{};
+        }
+    }
+};
+
+namespace detail {
+
+// position of (row, col) in the upper triangle of an n x n symmetric matrix, stored row by row
+constexpr std::size_t upper_index(std::size_t n, std::size_t row, std::size_t col) {
+    if (row > col) {
+        std::swap(row, col);
+    }
+    return row * n - row * (row - 1) / 2 + (col - row);
+}
+
+} // namespace detail
+
+// Gradient and Hessian of the expression E with respect to var<i>...
+// Only the upper triangle of the symmetric Hessian is built, row by row.
+// Entries that are structurally zero are not_dependent.
+template <typename E, typename Gradient, typename Upper, int... i>
+struct hessian_expr {
+    static constexpr std::size_t size = sizeof...(i);
+
+    // position of (row, col) in upper
+    static constexpr std::size_t index(std::size_t row, std::size_t col) {
+        return detail::upper_index(size, row, col);
+    }
+
+    template <std::size_t row, std::size_t col>
+    using entry_type = std::tuple_element_t<index(row, col), Upper>;
+
+    template <std::size_t row, std::size_t col>
+    static constexpr bool is_zero = !is_dependent<entry_type<row, col>>;
+
+    template <std::size_t row, std::size_t col>
+    constexpr const entry_type<row, col>& entry() const {
+        return std::get<index(row, col)>(upper);
+    }
+
+    E source;
+    Gradient gradient;
+    Upper upper;
+};
+
+template <typename T, std::size_t n>
+struct hessian_value {
+    std::array<T, n> gradient;
+    std::array<std::array<T, n>, n> hessian;
+};
+
+namespace detail {
+
+template <int i, typename Vi, int j, typename Vj, typename E>
+constexpr auto second_derivative(const E& e) {
+    auto h = xform_second_derivative<i, Vi, j, Vj>{}(e);
+    if constexpr (is_dependent<decltype(h)>) {
+        return et::as_expr(std::move(h));
+    }
+    else {
+        return h;
+    }
+}
+
+template <typename E, int... i, std::size_t... k>
+constexpr auto make_upper(const E& e, std::integer_sequence<int, i...>, std::index_sequence<k...>) {
+    constexpr std::array<int, sizeof...(i)> vars = {i...};
+    constexpr std::size_t n = sizeof...(i);
+    // k-th entry of the upper triangle
+    constexpr auto row_col = [] (std::size_t index) {
+        std::size_t row = 0;
+        while (index >= n - row) {
+            index -= n - row;
+            ++row;
+        }
+        return std::pair{row, row + index};
+    };
+    return std::tuple{second_derivative<vars[row_col(k).first], var_type_t<vars[row_col(k).first], E>,
+                                        vars[row_col(k).second], var_type_t<vars[row_col(k).second], E>>(e)...};
+}
+
+template <typename T, typename D>
+constexpr T value_of(const D& d) {
+    if constexpr (is_dependent<D>) {
+        return static_cast<T>(evaluate(d));
+    }
+    else {
+        return T{};
+    }
+}
+
+// derivatives of not_dependent expressions are wrapped by derivative()
+template <typename D>
+inline constexpr bool is_zero_entry = !is_dependent<D> || std::is_same_v<D, et::expr<not_dependent>>;
+
+template <typename E, int... i>
+inline constexpr bool depends_on = (... || !std::is_void_v<typename var_type<i, E>::type>);
+
+// value, gradient and upper Hessian triangle of a subexpression
+template <typename T, std::size_t n>
+struct second_order {
+    T value{};
+    std::array<T, n> gradient{};
+    std::array<T, n * (n + 1) / 2> upper{};
+};
+
+// Evaluates value, gradient and Hessian of every node of an expression once,
+// bottom up. The operands of a node are replaced by terminals holding their
+// values, var<k> for the k-th operand if it depends on the variables, and the
+// node is differentiated by the symbolic rules with respect to these local
+// variables; the chain rule combines the local derivatives with the
+// gradients and Hessians of the operands.
+template <typename T, int... i>
+struct second_order_evaluator {
+    static constexpr std::size_t n = sizeof...(i);
+    using result = second_order<T, n>;
+
+    template <typename E>
+    static constexpr bool dependent = depends_on<std::remove_cvref_t<E>, i...>;
+
+    template <typename E>
+    constexpr result operator()(const E& e) const {
+        if constexpr (dependent<E>) {
+            return node(e);
+        }
+        else {
+            return {.value = static_cast<T>(et::evaluate(e))};
+        }
+    }
+
+    template <int k, typename V>
+    constexpr result node(const et::expr<op::var<k>, V>& e) const {
+        constexpr std::array<int, n> vars = {i...};
+        constexpr std::size_t position = [&] {
+            std::size_t p = 0;
+            while (vars[p] != k) {
+                ++p;
+            }
+            return p;
+        }();
+        result r{.value = static_cast<T>(et::evaluate(e))};
+        r.gradient[position] = T{1};
+        return r;
+    }
+
+    // only the selected operand is differentiated, like xform_second_derivative
+    template <typename Pred, typename LHS, typename RHS>
+    constexpr result node(const et::expr<et::op::select, Pred, LHS, RHS>& e) const {
+        return et::evaluate(e.arg1) ? (*this)(e.arg2) : (*this)(e.arg3);
+    }
+
+    template <typename Op, typename Arg1>
+    constexpr result node(const et::expr<Op, Arg1>& e) const {
+        return apply(e.op, e.arg1);
+    }
+
+    template <typename Op, typename Arg1, typename Arg2>
+    constexpr result node(const et::expr<Op, Arg1, Arg2>& e) const {
+        return apply(e.op, e.arg1, e.arg2);
+    }
+
+    template <typename Op, typename Arg1, typename Arg2, typename Arg3>
+    constexpr result node(const et::expr<Op, Arg1, Arg2, Arg3>& e) const {
+        return apply(e.op, e.arg1, e.arg2, e.arg3);
+    }
+
+    // the evaluated operand: result if it depends on the variables, its value otherwise
+    template <typename A>
+    constexpr auto operand(const A& a) const {
+        if constexpr (dependent<A>) {
+            return (*this)(a);
+        }
+        else {
+            return et::evaluate(a);
+        }
+    }
+
+    template <int k, typename V>
+    static constexpr auto local(V& v) {
+        if constexpr (std::is_same_v<V, result>) {
+            return var<k>(v.value);
+        }
+        else {
+            return et::expr(v);
+        }
+    }
+
+    template <typename V>
+    static constexpr const result* operand_result(const V& v) {
+        if constexpr (std::is_same_v<V, result>) {
+            return &v;
+        }
+        else {
+            return nullptr;
+        }
+    }
+
+    template <typename Op, typename... Args>
+    constexpr result apply(const Op& op, const Args&... args) const {
+        constexpr std::size_t m = sizeof...(Args);
+        auto operands = std::tuple{operand(args)...};
+
+        return [&] <std::size_t... k> (std::index_sequence<k...>) {
+            auto f = et::expr(Op(op), local<static_cast<int>(k)>(std::get<k>(operands))...);
+            using F = decltype(f);
+
+            const std::array<T, m> df = {value_of<T>(xform_derivative<static_cast<int>(k), var_type_t<static_cast<int>(k), F>>{}(f))...};
+            const auto ddf_upper = make_upper(f, std::integer_sequence<int, static_cast<int>(k)...>{}, std::make_index_sequence<m * (m + 1) / 2>{});
+            const std::array<T, m * (m + 1) / 2> ddf = std::apply([] (const auto&... d) { return std::array<T, sizeof...(d)>{value_of<T>(d)...}; }, ddf_upper);
+            const std::array<const result*, m> a = {operand_result(std::get<k>(operands))...};
+
+            result r{.value = static_cast<T>(et::evaluate(f))};
+            for (std::size_t u = 0; u < m; ++u) {
+                if (!a[u]) {
+                    continue;
+                }
+                for (std::size_t p = 0; p < n; ++p) {
+                    r.gradient[p] += df[u] * a[u]->gradient[p];
+                }
+                for (std::size_t q = 0; q < r.upper.size(); ++q) {
+                    r.upper[q] += df[u] * a[u]->upper[q];
+                }
+                for (std::size_t w = u; w < m; ++w) {
+                    if (!a[w]) {
+                        continue;
+                    }
+                    const T c = ddf[upper_index(m, u, w)];
+                    for (std::size_t p = 0; p < n; ++p) {
+                        for (std::size_t q = p; q < n; ++q) {
+                            T outer = a[u]->gradient[p] * a[w]->gradient[q];
+                            if (u != w) {
+                                outer += a[w]->gradient[p] * a[u]->gradient[q];
+                            }
+                            r.upper[upper_index(n, p, q)] += c * outer;
+                        }
+                    }
+                }
+            }
+            return r;
+        }(std::make_index_sequence<m>{});
+    }
+};
+
+} // namespace detail
+
+// Gradient and Hessian of e with respect to var<i>..., e.g.
+//     auto h = hessian<0, 1>(x * x * y);
+//     auto v = evaluate_all(h);   // v.gradient[0], v.hessian[0][1]
+// Every mixed partial is built once, entries (i, j) and (j, i) are the same
+// expression. The result keeps a copy of e and refers to its terminals.
+template <int... i, typename E>
+    requires (sizeof...(i) > 0)
+constexpr auto hessian(const E& e) {
+    constexpr std::size_t n = sizeof...(i);
+    auto gradient = std::tuple{derivative<i, detail::var_type_t<i, E>>(e)...};
+    auto upper = detail::make_upper(e, std::integer_sequence<int, i...>{}, std::make_index_sequence<n * (n + 1) / 2>{});
+    return hessian_expr<E, decltype(gradient), decltype(upper), i...>{e, std::move(gradient), std::move(upper)};
+}
+
+template <int... i, typename E, typename... T>
+constexpr auto hessian(const E& e, const et::expr<op::var<i>, T>&... /*v*/) {
+    return hessian<i...>(e);
+}
+
+// Evaluates the gradient and the Hessian in one pass over e: every node of e
+// is evaluated once together with its first and second derivatives, so
+// subtrees shared by several entries are not evaluated again for each of
+// them. Structural zeros are T{}.
+template <typename T = double, typename E, typename G, typename U, int... i>
+constexpr hessian_value<T, sizeof...(i)> evaluate_all(const hessian_expr<E, G, U, i...>& h) {
+    using H = hessian_expr<E, G, U, i...>;
+    constexpr std::size_t n = H::size;
+    const auto r = detail::second_order_evaluator<T, i...>{}(h.source);
+
+    hessian_value<T, n> v{};
+    [&] <std::size_t... k> (std::index_sequence<k...>) {
+        ((v.gradient[k] = detail::is_zero_entry<std::tuple_element_t<k, G>> ? T{} : r.gradient[k]), ...);
+    }(std::make_index_sequence<n>{});
+    [&] <std::size_t... k> (std::index_sequence<k...>) {
+        const std::array<bool, sizeof...(k)> zero = {detail::is_zero_entry<std::tuple_element_t<k, U>>...};
+        for (std::size_t row = 0; row < n; ++row) {
+            for (std::size_t col = 0; col < n; ++col) {
+                const std::size_t q = H::index(row, col);
+                v.hessian[row][col] = zero[q] ? T{} : r.upper[q];
+            }
+        }
+    }(std::make_index_sequence<std::tuple_size_v<U>>{});
+    return v;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+template <typename Exprs, int... i>
+struct jacobian_pattern;
+
+template <typename... E, int... i>
+struct jacobian_pattern<std::tuple<E...>, i...> {
+    static constexpr std::size_t rows = sizeof...(E);
+    static constexpr std::size_t cols = sizeof...(i);
+    static constexpr std::array<int, cols> vars = {i...};
+
+    template <std::size_t r>
+    using row_expr = std::remove_cvref_t<std::tuple_element_t<r, std::tuple<E...>>>;
+
+    template <std::size_t r, std::size_t c>
+    using partial = xform_derivative<vars[c], var_type_t<vars[c], row_expr<r>>>;
+
+    template <std::size_t r, std::size_t... c>
+    static constexpr std::array<bool, cols> dense_row(std::index_sequence<c...>) {
+        // not_dependent partials are structural zeros
+        return {is_dependent<decltype(partial<r, c>{}(std::declval<const row_expr<r>&>()))>...};
+    }
+
+    template <std::size_t... r>
+    static constexpr std::array<std::array<bool, cols>, rows> make_dense(std::index_sequence<r...>) {
+        return {dense_row<r>(std::make_index_sequence<cols>{})...};
+    }
+
+    static constexpr auto dense = make_dense(std::make_index_sequence<rows>{});
+
+    static constexpr std::size_t nnz = [] {
+        std::size_t n = 0;
+        for (const auto& row : dense) {
+            for (bool nonzero : row) {
+                n += nonzero;
+            }
+        }
+        return n;
+    }();
+
+    static constexpr auto row_offsets = [] {
+        std::array<std::size_t, rows + 1> offsets{};
+        for (std::size_t r = 0; r < rows; ++r) {
+            offsets[r + 1] = offsets[r];
+            for (bool nonzero : dense[r]) {
+                offsets[r + 1] += nonzero;
+            }
+        }
+        return offsets;
+    }();
+
+    static constexpr auto columns = [] {
+        std::array<std::size_t, nnz> index{};
+        std::size_t k = 0;
+        for (std::size_t r = 0; r < rows; ++r) {
+            for (std::size_t c = 0; c < cols; ++c) {
+                if (dense[r][c]) {
+                    index[k++] = c;
+                }
+            }
+        }
+        return index;
+    }();
+
+    static constexpr std::size_t row_of(std::size_t k) {
+        std::size_t r = 0;
+        while (row_offsets[r + 1] <= k) {
+            ++r;
+        }
+        return r;
+    }
+};
+
+} // namespace detail
+
+// Jacobian of several expressions with respect to var<i>..., stored in
+// compressed sparse row form. The sparsity pattern is known at compile
+// time: partials that are not_dependent are not stored nor evaluated.
+// Holds copies of the expressions; the k-th nonzero entry is built from
+// them on access.
+template <typename Exprs, int... i>
+struct jacobian_expr {
+private:
+    using pattern = detail::jacobian_pattern<Exprs, i...>;
+
+public:
+    static constexpr std::size_t rows = pattern::rows;
+    static constexpr std::size_t cols = pattern::cols;
+    // number of structurally nonzero entries
+    static constexpr std::size_t nnz = pattern::nnz;
+    // entries of row r are [row_offsets[r], row_offsets[r + 1])
+    static constexpr std::array<std::size_t, rows + 1> row_offsets = pattern::row_offsets;
+    // column of every entry
+    static constexpr std::array<std::size_t, nnz> columns = pattern::columns;
+
+    template <std::size_t row, std::size_t col>
+    static constexpr bool is_nonzero = pattern::dense[row][col];
+
+    // k-th nonzero partial derivative, in row-major order
+    template <std::size_t k>
+        requires (k < nnz)
+    constexpr auto entry() const {
+        constexpr std::size_t r = pattern::row_of(k);
+        constexpr int v = pattern::vars[columns[k]];
+        return derivative<v, detail::var_type_t<v, typename pattern::template row_expr<r>>>(std::get<r>(exprs));
+    }
+
+    Exprs exprs;
+};
+
+// Jacobian of the expressions e with respect to var<i>..., e.g.
+//     auto j = jacobian(std::tuple(f, g), x, y);
+//     auto values = evaluate_all(j);   // j.nnz values
+template <int... i, typename... E>
+    requires (sizeof...(i) > 0)
+constexpr auto jacobian(const std::tuple<E...>& e) {
+    return jacobian_expr<std::tuple<E...>, i...>{e};
+}
+
+template <typename... E, int... i, typename... T>
+constexpr auto jacobian(const std::tuple<E...>& e, const et::expr<op::var<i>, T>&... /*v*/) {
+    return jacobian<i...>(e);
+}
+
+// Values of the nonzero entries, in the order of jacobian_expr::columns
+template <typename T = double, typename Exprs, int... i>
+constexpr std::array<T, jacobian_expr<Exprs, i...>::nnz> evaluate_all(const jacobian_expr<Exprs, i...>& j) {
+    return [&] <std::size_t... k> (std::index_sequence<k...>) {
+        return std::array<T, sizeof...(k)>{static_cast<T>(evaluate(j.template entry<k>()))...};
+    }(std::make_index_sequence<jacobian_expr<Exprs, i...>::nnz>{});
+}
+
 } // namespace autodiff
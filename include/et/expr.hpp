@@ -5,7 +5,9 @@
 
 #include "type_name.hpp"
 
+#include <cstddef>
 #include <functional>
+#include <iterator>
 #include <type_traits>
 #include <utility>
 
@@ -275,6 +277,17 @@ concept Terminal = !Expr<T>;
 
 } // namespace detail
 
+// Field is a terminal that holds one value per element of the index space,
+// e.g. std::vector or std::span. All other terminals are broadcast.
+template <typename T>
+concept Field = !Expr<T> && requires (T& t, std::size_t i) {
+    t[i];
+    std::size(t);
+};
+
+template <Field T>
+using field_element_t = std::remove_cvref_t<decltype(std::declval<T&>()[std::size_t{}])>;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace detail {
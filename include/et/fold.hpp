@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "expr.hpp"
+
+#include <ostream>
+#include <type_traits>
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// compile-time constant terminal
+template <auto v>
+struct lit {
+    using value_type = decltype(v);
+    static constexpr value_type value = v;
+
+    constexpr operator value_type() const noexcept {
+        return v;
+    }
+};
+
+template <auto v>
+std::ostream& operator<<(std::ostream& s, lit<v>) {
+    return s << v;
+}
+
+// Terminals whose value is encoded in their type. Specialise for other
+// stateless types that convert to their value in a constant expression.
+template <typename T>
+inline constexpr bool is_constant_v = false;
+
+template <typename T, T v>
+inline constexpr bool is_constant_v<std::integral_constant<T, v>> = true;
+
+template <auto v>
+inline constexpr bool is_constant_v<lit<v>> = true;
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+template <typename T>
+inline constexpr bool is_constant_expr = is_constant_v<T>;
+
+template <typename Arg>
+inline constexpr bool is_constant_expr<expr<Arg>> = is_constant_v<std::remove_cvref_t<Arg>>;
+
+template <typename Op, typename Arg1, typename... Args>
+inline constexpr bool is_constant_expr<expr<Op, Arg1, Args...>> =
+    std::is_empty_v<Op> && std::is_default_constructible_v<Op>
+    && is_constant_expr<std::remove_cvref_t<Arg1>>
+    && (is_constant_expr<std::remove_cvref_t<Args>> && ...);
+
+// subexpression that consists only of constants and can be evaluated at compile time
+template <typename E>
+concept Foldable = is_constant_expr<E> && arity<E> > 0 && requires {
+    typename lit<copy(evaluate(E{}))>;
+};
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace tr {
+
+// Replaces every largest constant subexpression by a single lit terminal.
+// Used with transform_matching.
+struct fold_constants {
+    template <typename Op, typename Arg1, typename... Args>
+        requires et::detail::Foldable<expr<Op, Arg1, Args...>>
+    constexpr auto operator()(const expr<Op, Arg1, Args...>& /*e*/) const {
+        return lit<et::detail::copy(evaluate(expr<Op, Arg1, Args...>{}))>{};
+    }
+};
+
+} // namespace tr
+
+template <typename E>
+constexpr decltype(auto) fold_constants(const E& e) {
+    return transform_matching(e, tr::fold_constants{});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
@@ -4,36 +4,53 @@
 #pragma once
 
 #include "expr.hpp"
+#include "cost.hpp"
+#include "print.hpp"
+#include "profile.hpp"
 
+#include <charconv>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <map>
 #include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 namespace et {
 
+////////////////////////////////////////////////////////////////////////////////
+
+// Tree export: every occurrence of a subexpression is a separate node
+
 template <typename T>
-std::ostream& write_dot_nodes(std::ostream& s, T&& /*e*/, const std::string& prefix) {
-    s << "    " << prefix << " [label=\"" << et::symbol_v<T&&> << "\",shape=box];\n";
-    return s;
+int write_dot_nodes(std::ostream& s, T&& /*e*/, int& counter) {
+    int id = counter++;
+    s << "    n" << id << " [label=\"" << et::symbol_v<T&&> << "\",shape=box];\n";
+    return id;
 }
 
 template <typename Op, typename... Args>
-std::ostream& write_dot_nodes(std::ostream& s, const et::expr<Op, Args...>& e, const std::string& prefix) {
-
-    s << "    " << prefix << " [label=\"" << et::symbol_v<Op> << "\"];\n";
+int write_dot_nodes(std::ostream& s, const et::expr<Op, Args...>& e, int& counter) {
+    int id = counter++;
+    s << "    n" << id << " [label=\"" << et::symbol_v<Op> << "\"];\n";
 
     if constexpr (sizeof...(Args) > 0) {
-        s << "    " << prefix << " -> " << (prefix + "_1") << " ;\n";
-        write_dot_nodes(s, e.arg1, prefix + "_1");
+        int child = write_dot_nodes(s, e.arg1, counter);
+        s << "    n" << id << " -> n" << child << " ;\n";
     }
     if constexpr (sizeof...(Args) > 1) {
-        s << "    " << prefix << " -> " << (prefix + "_2") << " ;\n";
-        write_dot_nodes(s, e.arg2, prefix + "_2");
+        int child = write_dot_nodes(s, e.arg2, counter);
+        s << "    n" << id << " -> n" << child << " ;\n";
     }
     if constexpr (sizeof...(Args) > 2) {
-        s << "    " << prefix << " -> " << (prefix + "_3") << " ;\n";
-        write_dot_nodes(s, e.arg3, prefix + "_3");
+        int child = write_dot_nodes(s, e.arg3, counter);
+        s << "    n" << id << " -> n" << child << " ;\n";
     }
 
-    return s;
+    return id;
 }
 
 template <et::Expr E>
@@ -41,11 +58,247 @@ std::ostream& write_dot_graph(std::ostream& s, const E& e) {
     s << "digraph \"\" {\n";
     s << "    node [fontname=\"monospace\"];\n";
 
-    write_dot_nodes(s, e, "root");
+    int counter = 0;
+    write_dot_nodes(s, e, counter);
 
     s << "}\n";
 
     return s;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// DAG export: identical subexpressions are collapsed into one node.
+// Terminals held by reference are identical if they refer to the same object,
+// terminals held by value if they have the same type and printed value.
+// Operations with state (coefficients, table pointers) are identical if the
+// state has the same bytes, or, when it is not trivially copyable, if it is
+// the same object.
+
+struct graph_node {
+    std::string label;
+    std::string_view type_name;
+    bool terminal = false;
+    std::vector<int> children;
+    // cost of the operation of this node and of the whole subtree below it
+    cost node_cost;
+    cost tree_cost;
+    // number of times the node is evaluated when the expression is evaluated as a tree
+    int count = 1;
+    // time measured by the profiler for kernels evaluating this subexpression
+    double seconds = 0.0;
+};
+
+struct expr_graph {
+    std::vector<graph_node> nodes;
+    int root = -1;
+};
+
+namespace detail {
+
+// Nodes are passed to the sink once, when first visited, after their
+// children; the sink never sees a repeated node, only the final counts.
+template <typename Sink>
+struct graph_builder {
+    Sink& sink;
+    std::map<std::string, int, std::less<>> ids;
+    std::vector<int> counts;
+    std::map<std::uint64_t, double> profiled;
+
+    explicit graph_builder(Sink& s) : sink(s) {
+        if constexpr (profile::enabled) {
+            for (const auto& e : profile::snapshot()) {
+                profiled[e.hash] += e.stats.seconds;
+            }
+        }
+    }
+
+    int add(const std::string& key, graph_node&& node) {
+        if (auto it = ids.find(key); it != ids.end()) {
+            counts[it->second] += 1;
+            return it->second;
+        }
+        int id = static_cast<int>(counts.size());
+        counts.push_back(1);
+        ids.emplace(key, id);
+        sink(id, std::move(node));
+        return id;
+    }
+
+    // shortest text that reads back as the same value
+    template <typename T>
+    static std::string exact_text(T v) {
+        if constexpr (std::is_same_v<T, bool>) {
+            return v ? "1" : "0";
+        }
+        else {
+            char buf[64];
+            auto [ptr, ec] = std::to_chars(buf, buf + sizeof buf, v);
+            return std::string(buf, ptr);
+        }
+    }
+
+    // equal bytes imply equal values; equal values with different bytes
+    // (padding, signed zeros) only cost a missed merge
+    template <typename Op>
+    static void append_state(std::string& key, const Op& op) {
+        if constexpr (std::is_empty_v<Op>) {
+            return;
+        }
+        else if constexpr (std::is_trivially_copyable_v<Op>) {
+            static constexpr char digits[] = "0123456789abcdef";
+            key += " =";
+            const auto* bytes = reinterpret_cast<const unsigned char*>(&op);
+            for (std::size_t i = 0; i < sizeof(Op); ++i) {
+                key += digits[bytes[i] >> 4];
+                key += digits[bytes[i] & 15];
+            }
+        }
+        else {
+            std::ostringstream address;
+            address << " @" << static_cast<const void*>(&op);
+            key += address.str();
+        }
+    }
+
+    template <typename T>
+    double measured() const {
+        if (auto it = profiled.find(get_type_hash<T>()); it != profiled.end()) {
+            return it->second;
+        }
+        return 0.0;
+    }
+
+    // Stored is the declared type of the member holding the terminal
+    template <typename Stored, typename T>
+    int visit(const T& t) {
+        if constexpr (Expr<T>) {
+            return visit_expr(t);
+        }
+        else {
+            std::ostringstream label;
+            tr::print{label}(t);
+
+            std::ostringstream key;
+            key << get_type_name<T>() << ' ';
+            if constexpr (std::is_reference_v<Stored> || !Streamable<T>) {
+                key << '@' << static_cast<const void*>(&t);
+            }
+            else if constexpr (std::is_arithmetic_v<T>) {
+                key << '=' << exact_text(t);
+            }
+            else {
+                // the label is rounded, values differing in late digits are distinct nodes
+                key << '=' << std::setprecision(std::numeric_limits<long double>::max_digits10) << t;
+            }
+
+            return add(key.str(), graph_node{
+                .label = label.str(),
+                .type_name = get_type_name<T>(),
+                .terminal = true,
+                .children = {},
+                .node_cost = {},
+                .tree_cost = cost_v<T>,
+            });
+        }
+    }
+
+    template <typename Arg>
+    int visit_expr(const expr<Arg>& e) {
+        return visit<Arg>(e.arg);
+    }
+
+    template <typename Op, typename Arg1>
+    int visit_expr(const expr<Op, Arg1>& e) {
+        return add_op(e, {visit<Arg1>(e.arg1)});
+    }
+
+    template <typename Op, typename Arg1, typename Arg2>
+    int visit_expr(const expr<Op, Arg1, Arg2>& e) {
+        int c1 = visit<Arg1>(e.arg1);
+        int c2 = visit<Arg2>(e.arg2);
+        return add_op(e, {c1, c2});
+    }
+
+    template <typename Op, typename Arg1, typename Arg2, typename Arg3>
+    int visit_expr(const expr<Op, Arg1, Arg2, Arg3>& e) {
+        int c1 = visit<Arg1>(e.arg1);
+        int c2 = visit<Arg2>(e.arg2);
+        int c3 = visit<Arg3>(e.arg3);
+        return add_op(e, {c1, c2, c3});
+    }
+
+    template <typename E>
+    int add_op(const E& e, std::vector<int> children) {
+        using Op = decltype(E::op);
+
+        std::string key(get_type_name<Op>());
+        append_state(key, e.op);
+        for (int c : children) {
+            key += ' ';
+            key += std::to_string(c);
+        }
+
+        return add(key, graph_node{
+            .label = std::string(symbol_v<Op>),
+            .type_name = get_type_name<E>(),
+            .terminal = false,
+            .children = std::move(children),
+            .node_cost = node_cost_v<E>,
+            .tree_cost = cost_v<E>,
+            .seconds = measured<E>(),
+        });
+    }
+};
+
+// pieces of the DAG writers, shared by the graph and the streaming overloads
+
+void write_dot_dag_begin(std::ostream& s);
+void write_dot_dag_node(std::ostream& s, int id, const graph_node& n);
+void write_dot_dag_end(std::ostream& s, const std::vector<int>& counts);
+
+void write_json_dag_begin(std::ostream& s);
+void write_json_dag_node(std::ostream& s, int id, const graph_node& n);
+void write_json_dag_end(std::ostream& s, int root, const std::vector<int>& counts);
+
+} // namespace detail
+
+template <typename E>
+expr_graph make_graph(const E& e) {
+    expr_graph g;
+    auto store = [&g](int /*id*/, graph_node&& n) { g.nodes.push_back(std::move(n)); };
+    detail::graph_builder b(store);
+    g.root = b.template visit<E>(e);
+    for (std::size_t id = 0; id < g.nodes.size(); ++id) {
+        g.nodes[id].count = b.counts[id];
+    }
+    return g;
+}
+
+std::ostream& write_dot_dag(std::ostream& s, const expr_graph& g);
+std::ostream& write_json_dag(std::ostream& s, const expr_graph& g);
+
+// The expression overloads write every node as soon as it is first visited,
+// without building the graph; only the dedup keys and the counts are kept.
+
+template <et::Expr E>
+std::ostream& write_dot_dag(std::ostream& s, const E& e) {
+    detail::write_dot_dag_begin(s);
+    auto write = [&s](int id, graph_node&& n) { detail::write_dot_dag_node(s, id, n); };
+    detail::graph_builder b(write);
+    b.template visit<E>(e);
+    detail::write_dot_dag_end(s, b.counts);
+    return s;
+}
+
+template <et::Expr E>
+std::ostream& write_json_dag(std::ostream& s, const E& e) {
+    detail::write_json_dag_begin(s);
+    auto write = [&s](int id, graph_node&& n) { detail::write_json_dag_node(s, id, n); };
+    detail::graph_builder b(write);
+    int root = b.template visit<E>(e);
+    detail::write_json_dag_end(s, root, b.counts);
+    return s;
+}
+
 } // namespace et
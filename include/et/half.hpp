@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <type_traits>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// 16-bit storage of floating point fields.
+//
+// packed_view presents an array of 16-bit words as a field of float (or
+// double) values. In expressions elements are converted on load, as
+// destination of et::assign they are rounded to nearest even on store.
+// IEEE binary16 conversions use F16C instructions when the target has them
+// (-mf16c, -march=native), bfloat16 conversions are bit shifts.
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+constexpr float binary16_to_float(std::uint16_t h) {
+    const std::uint32_t sign = static_cast<std::uint32_t>(h & 0x8000u) << 16;
+    std::uint32_t exp = (h >> 10) & 0x1fu;
+    std::uint32_t mant = h & 0x3ffu;
+    std::uint32_t bits;
+    if (exp == 0) {
+        if (mant == 0) {
+            bits = sign;
+        }
+        else {
+            // subnormal, normalise
+            exp = 113;
+            while (!(mant & 0x400u)) {
+                mant <<= 1;
+                --exp;
+            }
+            bits = sign | (exp << 23) | ((mant & 0x3ffu) << 13);
+        }
+    }
+    else if (exp == 31) {
+        // NaNs are made quiet, like the hardware conversion does
+        bits = sign | 0x7f800000u | (mant << 13) | (mant ? 0x400000u : 0u);
+    }
+    else {
+        bits = sign | ((exp + 112) << 23) | (mant << 13);
+    }
+    return std::bit_cast<float>(bits);
+}
+
+constexpr std::uint16_t float_to_binary16(float f) {
+    const std::uint32_t x = std::bit_cast<std::uint32_t>(f);
+    const auto sign = static_cast<std::uint16_t>((x >> 16) & 0x8000u);
+    const std::uint32_t abs = x & 0x7fffffffu;
+
+    auto round = [] (std::uint32_t m, int shift) {
+        const std::uint32_t half = 1u << (shift - 1);
+        const std::uint32_t rem = m & ((1u << shift) - 1);
+        std::uint32_t r = m >> shift;
+        if (rem > half || (rem == half && (r & 1))) {
+            ++r;
+        }
+        return r;
+    };
+
+    if (abs >= 0x7f800000u) {
+        // infinity, or NaN made quiet keeping the upper bits of the payload
+        return static_cast<std::uint16_t>(sign | 0x7c00u | (abs > 0x7f800000u ? 0x200u | ((abs >> 13) & 0x3ffu) : 0u));
+    }
+    if (abs >= 0x477ff000u) {
+        // rounds to infinity
+        return static_cast<std::uint16_t>(sign | 0x7c00u);
+    }
+    if (abs < 0x38800000u) {
+        // subnormal half, or zero
+        if (abs <= 0x33000000u) {
+            return sign;
+        }
+        const std::uint32_t e = abs >> 23;
+        const std::uint32_t m = (abs & 0x7fffffu) | 0x800000u;
+        return static_cast<std::uint16_t>(sign | round(m, static_cast<int>(126 - e)));
+    }
+    // rebias the exponent, a carry out of the mantissa increments it
+    return static_cast<std::uint16_t>(sign | round(abs - 0x38000000u, 13));
+}
+
+// double to float rounded to odd: truncated, with the last bit set if the
+// conversion is inexact. Rounding that to a format at least two bits
+// shorter gives the correctly rounded result, double rounding through the
+// nearest float may not.
+constexpr float to_float_round_odd(double d) {
+    const float f = static_cast<float>(d);
+    if (static_cast<double>(f) == d || d != d) {
+        return f;
+    }
+    std::uint32_t x = std::bit_cast<std::uint32_t>(f);
+    if ((f < 0 ? -static_cast<double>(f) : static_cast<double>(f)) > (d < 0 ? -d : d)) {
+        --x;
+    }
+    return std::bit_cast<float>(x | 1u);
+}
+
+} // namespace detail
+
+// IEEE 754 binary16
+struct binary16 {
+    static float to_float(std::uint16_t h) {
+#if defined(__F16C__)
+        return _cvtsh_ss(h);
+#else
+        return detail::binary16_to_float(h);
+#endif
+    }
+
+    static std::uint16_t from_float(float f) {
+#if defined(__F16C__)
+        return static_cast<std::uint16_t>(_cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT));
+#else
+        return detail::float_to_binary16(f);
+#endif
+    }
+};
+
+// bfloat16: the upper half of a binary32
+struct bfloat16 {
+    static constexpr float to_float(std::uint16_t h) {
+        return std::bit_cast<float>(static_cast<std::uint32_t>(h) << 16);
+    }
+
+    static constexpr std::uint16_t from_float(float f) {
+        const std::uint32_t x = std::bit_cast<std::uint32_t>(f);
+        if ((x & 0x7fffffffu) > 0x7f800000u) {
+            // keep NaN quiet
+            return static_cast<std::uint16_t>((x >> 16) | 0x40u);
+        }
+        return static_cast<std::uint16_t>((x + 0x7fffu + ((x >> 16) & 1u)) >> 16);
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Field of T values stored as 16-bit words in the given Format. Bits is
+// const std::uint16_t for read-only views.
+template <typename Format, typename T = float, typename Bits = std::uint16_t>
+class packed_view {
+public:
+    using value_type = T;
+
+    static constexpr std::size_t storage_bytes = sizeof(Bits);
+
+    // element of a writable view
+    class reference {
+    public:
+        explicit reference(Bits& bits) : bits_(bits) {}
+
+        operator T() const {
+            return static_cast<T>(Format::to_float(bits_));
+        }
+
+        reference& operator=(T value) {
+            if constexpr (std::is_same_v<T, double>) {
+                bits_ = Format::from_float(detail::to_float_round_odd(value));
+            }
+            else {
+                bits_ = Format::from_float(static_cast<float>(value));
+            }
+            return *this;
+        }
+
+        reference& operator=(const reference& other) {
+            bits_ = other.bits_;
+            return *this;
+        }
+
+    private:
+        Bits& bits_;
+    };
+
+    packed_view() = default;
+    explicit packed_view(std::span<Bits> bits) : bits_(bits) {}
+
+    // used by evaluation
+    T load(std::size_t i) const {
+        return static_cast<T>(Format::to_float(bits_[i]));
+    }
+
+    auto operator[](std::size_t i) const {
+        if constexpr (std::is_const_v<Bits>) {
+            return load(i);
+        }
+        else {
+            return reference(bits_[i]);
+        }
+    }
+
+    std::size_t size() const {
+        return bits_.size();
+    }
+
+    Bits* data() const {
+        return bits_.data();
+    }
+
+private:
+    std::span<Bits> bits_;
+};
+
+// View of a contiguous range of std::uint16_t as binary16 or bfloat16 values
+template <typename T = float, typename R>
+auto as_binary16(R&& bits) {
+    using Bits = std::remove_reference_t<decltype(*std::data(bits))>;
+    return packed_view<binary16, T, Bits>(std::span<Bits>(std::data(bits), std::size(bits)));
+}
+
+template <typename T = float, typename R>
+auto as_bfloat16(R&& bits) {
+    using Bits = std::remove_reference_t<decltype(*std::data(bits))>;
+    return packed_view<bfloat16, T, Bits>(std::span<Bits>(std::data(bits), std::size(bits)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "array.hpp"
+#include "math.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+// Checked assignment: every stored value is tested with op::isfinite in the
+// same loop that computes it. The tests are OR-ed into a flag without
+// branching; only when the flag is set the destination is scanned again to
+// find the first bad element. Does not work with -ffinite-math-only
+// (implied by -ffast-math), which makes isfinite always true.
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Evaluation policy for et::assign
+struct check_finite {};
+
+struct health_report {
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    // index of the first NaN or infinity stored, npos if there is none
+    std::size_t first_nonfinite = npos;
+
+    bool ok() const {
+        return first_nonfinite == npos;
+    }
+};
+
+namespace detail {
+
+inline bool& thread_nonfinite_flag() {
+    thread_local bool flag = false;
+    return flag;
+}
+
+template <typename Dst>
+std::size_t find_nonfinite(const Dst& dst, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!op::isfinite{}(evaluate_at(dst, i))) {
+            return i;
+        }
+    }
+    return health_report::npos;
+}
+
+// returns true if a non-finite value was stored
+template <typename Dst, typename E>
+bool assign_checked_loop(Dst& dst, const E& e, std::size_t n) {
+    using T = field_element_t<Dst>;
+    bool bad = false;
+    for (std::size_t i = 0; i < n; ++i) {
+        // check the value after conversion to the element type, a narrowing store may overflow
+        if constexpr (std::is_arithmetic_v<T>) {
+            T v = static_cast<T>(evaluate_at(e, i));
+            dst[i] = v;
+            bad |= !op::isfinite{}(v);
+        }
+        else {
+            // proxy destinations narrow inside the store, check what was stored
+            dst[i] = evaluate_at(e, i);
+            bad |= !op::isfinite{}(evaluate_at(dst, i));
+        }
+    }
+    return bad;
+}
+
+} // namespace detail
+
+// True if a checked assignment on the calling thread stored a non-finite
+// value since the last reset
+inline bool thread_nonfinite_seen() {
+    return detail::thread_nonfinite_flag();
+}
+
+inline void reset_thread_nonfinite() {
+    detail::thread_nonfinite_flag() = false;
+}
+
+template <Field Dst, typename E>
+health_report assign(Dst&& dst, const E& e, check_finite) {
+    const std::size_t n = std::size(dst);
+    assert(extent(e) == n || extent(e) == 0);
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+    constexpr cost c = assign_cost_v<std::remove_cvref_t<Dst>, std::remove_cvref_t<decltype(h)>>;
+    const bool bad = detail::profiled<profile::assign_kernel, E>(c, n, [&] {
+        if (detail::plan_assign(dst, h).strategy == detail::assign_strategy::forward) {
+            return detail::assign_checked_loop(dst, h, n);
+        }
+        // the order of evaluation matters, check in a separate pass
+        detail::assign_dispatch(dst, h, n);
+        return detail::find_nonfinite(dst, n) != health_report::npos;
+    });
+
+    health_report report;
+    if (bad) {
+        report.first_nonfinite = detail::find_nonfinite(dst, n);
+        detail::thread_nonfinite_flag() = true;
+    }
+    return report;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
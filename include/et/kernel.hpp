@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "array.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Type-erased array assignment into fields of T, e.g. to select a boundary
+// condition at runtime:
+//     et::kernel<double> bc = wall ? et::kernel<double>(et::expr(u) * 0.0)
+//                                  : et::kernel<double>(et::expr(u_in) + gradient * dx);
+//     bc(face_values);
+// The expression is copied into the handle, fields referenced by it must
+// outlive the handle. Expressions of up to Capacity bytes are stored inline.
+// Every call is one indirect call evaluating a whole range with the fully
+// instantiated loop.
+template <typename T, std::size_t Capacity = 64>
+class kernel {
+public:
+    kernel() = default;
+
+    template <typename E>
+        requires (!std::is_same_v<std::remove_cvref_t<E>, kernel>)
+    explicit kernel(E&& e)
+        : vtable_(&vtable_for<std::remove_cvref_t<E>>)
+    {
+        using E1 = std::remove_cvref_t<E>;
+        if constexpr (fits<E1>) {
+            object_ = ::new (static_cast<void*>(buffer_)) E1(std::forward<E>(e));
+        }
+        else {
+            object_ = new E1(std::forward<E>(e));
+        }
+    }
+
+    kernel(const kernel& other)
+        : vtable_(other.vtable_)
+        , object_(other.vtable_ ? other.vtable_->clone(other.object_, buffer_) : nullptr)
+    {
+    }
+
+    kernel(kernel&& other) noexcept
+        : vtable_(other.vtable_)
+    {
+        take(std::move(other));
+    }
+
+    kernel& operator=(const kernel& other) {
+        if (this != &other) {
+            kernel tmp(other);
+            *this = std::move(tmp);
+        }
+        return *this;
+    }
+
+    kernel& operator=(kernel&& other) noexcept {
+        if (this != &other) {
+            reset();
+            vtable_ = other.vtable_;
+            take(std::move(other));
+        }
+        return *this;
+    }
+
+    ~kernel() {
+        reset();
+    }
+
+    explicit operator bool() const {
+        return vtable_ != nullptr;
+    }
+
+    // number of elements of the fields referenced by the expression
+    std::size_t size() const {
+        assert(vtable_);
+        return vtable_->extent(object_);
+    }
+
+    // same as et::assign(dst, e)
+    void operator()(std::span<T> dst) const {
+        assert(vtable_);
+        vtable_->assign(object_, dst);
+    }
+
+    // evaluates elements [begin, end) into dst[begin, end), e.g. one chunk
+    // of a parallel loop; dst must not alias the fields of the expression
+    void operator()(std::span<T> dst, std::size_t begin, std::size_t end) const {
+        assert(vtable_);
+        assert(begin <= end && end <= dst.size());
+        vtable_->assign_range(object_, dst.data(), begin, end);
+    }
+
+private:
+    struct vtable {
+        void (*assign)(const void* e, std::span<T> dst);
+        void (*assign_range)(const void* e, T* dst, std::size_t begin, std::size_t end);
+        std::size_t (*extent)(const void* e);
+        // copies into buffer if the expression fits, to the heap otherwise
+        void* (*clone)(const void* e, void* buffer);
+        // moves an inline expression to another buffer
+        void* (*relocate)(void* e, void* buffer) noexcept;
+        void (*destroy)(void* e);
+    };
+
+    template <typename E>
+    static constexpr bool fits = sizeof(E) <= Capacity && alignof(E) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible_v<E>;
+
+    template <typename E>
+    static constexpr vtable vtable_for = {
+        [] (const void* e, std::span<T> dst) {
+            et::assign(dst, *static_cast<const E*>(e));
+        },
+        [] (const void* e, T* dst, std::size_t begin, std::size_t end) {
+            decltype(auto) f = fold_constants(*static_cast<const E*>(e));
+            decltype(auto) h = hoist_invariants(f);
+            for (std::size_t i = begin; i < end; ++i) {
+                dst[i] = evaluate_at(h, i);
+            }
+        },
+        [] (const void* e) {
+            return extent(*static_cast<const E*>(e));
+        },
+        [] (const void* e, void* buffer) -> void* {
+            if constexpr (fits<E>) {
+                return ::new (buffer) E(*static_cast<const E*>(e));
+            }
+            else {
+                return new E(*static_cast<const E*>(e));
+            }
+        },
+        [] (void* e, void* buffer) noexcept -> void* {
+            if constexpr (fits<E>) {
+                return ::new (buffer) E(std::move(*static_cast<E*>(e)));
+            }
+            else {
+                return e;
+            }
+        },
+        [] (void* e) {
+            if constexpr (fits<E>) {
+                static_cast<E*>(e)->~E();
+            }
+            else {
+                delete static_cast<E*>(e);
+            }
+        },
+    };
+
+    bool inline_object() const {
+        return object_ == static_cast<const void*>(buffer_);
+    }
+
+    // takes the object of other, whose vtable is already copied
+    void take(kernel&& other) noexcept {
+        if (!other.vtable_) {
+            object_ = nullptr;
+        }
+        else if (other.inline_object()) {
+            object_ = vtable_->relocate(other.object_, buffer_);
+            other.reset();
+        }
+        else {
+            object_ = std::exchange(other.object_, nullptr);
+            other.vtable_ = nullptr;
+        }
+    }
+
+    void reset() {
+        if (vtable_) {
+            vtable_->destroy(object_);
+            vtable_ = nullptr;
+            object_ = nullptr;
+        }
+    }
+
+    const vtable* vtable_ = nullptr;
+    void* object_ = nullptr;
+    alignas(std::max_align_t) std::byte buffer_[Capacity];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
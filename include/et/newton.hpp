@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "array.hpp"
+#include "derivative.hpp"
+#include "math.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+// Point-wise Newton solver: finds x[c] with residual(x[c]) == 0 in every
+// cell c, e.g. temperature from enthalpy:
+//     auto T = autodiff::var<0>(0.0);
+//     auto r = cp0 * T + 0.5 * cp1 * T * T - et::expr(h);
+//     et::solve_pointwise(r, T, temperature, 1e-12);
+// The unknown is a var<i> placeholder, its stored value is not used. The
+// derivative of the residual is built once with autodiff::derivative. Cells
+// are iterated in blocks of pointwise_lanes, each lane stops updating when it
+// has converged and the block stops when all lanes have.
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline constexpr std::size_t pointwise_lanes = 8;
+
+struct pointwise_report {
+    // largest number of iterations used by a block of cells
+    std::size_t iterations = 0;
+    // cells whose last step was still larger than the tolerance
+    std::size_t unconverged = 0;
+
+    bool ok() const {
+        return unconverged == 0;
+    }
+};
+
+namespace tr {
+
+// Replaces the unknown var<i> by the field of iterates. Used with transform_matching.
+template <int i, typename X>
+struct substitute_var {
+    X& x;
+
+    template <typename T>
+    constexpr auto operator()(const expr<autodiff::op::var<i>, T>& /*v*/) const {
+        return expr(autodiff::op::var<i>{}, x);
+    }
+};
+
+} // namespace tr
+
+namespace detail {
+
+// one block of cells [begin, begin + w), returns the number of iterations
+template <typename X, typename R, typename D>
+std::size_t newton_block(X& x, const R& r, const D& dr, std::size_t begin, std::size_t w,
+                         double tol, std::size_t max_iterations, std::size_t& unconverged) {
+    using T = field_element_t<X>;
+    bool active[pointwise_lanes];
+    for (std::size_t k = 0; k < pointwise_lanes; ++k) {
+        active[k] = k < w;
+    }
+    T step[pointwise_lanes];
+    std::size_t it = 0;
+    bool any = w > 0;
+    for (; it < max_iterations && any; ++it) {
+        // steps of all lanes first: no stores, so the lanes can be evaluated in SIMD
+        for (std::size_t k = 0; k < w; ++k) {
+            step[k] = static_cast<T>(evaluate_at(r, begin + k)) / static_cast<T>(evaluate_at(dr, begin + k));
+        }
+        any = false;
+        for (std::size_t k = 0; k < w; ++k) {
+            const T xc = x[begin + k];
+            // converged lanes keep their value
+            x[begin + k] = active[k] ? xc - step[k] : xc;
+            active[k] = active[k] && !(std::abs(step[k]) <= static_cast<T>(tol) * std::max(std::abs(xc), T{1}));
+            any |= active[k];
+        }
+    }
+    for (std::size_t k = 0; k < w; ++k) {
+        unconverged += active[k];
+    }
+    return it;
+}
+
+} // namespace detail
+
+// Solves residual == 0 for the unknown var<i> in every cell, starting from
+// and overwriting x. A cell has converged when the Newton step is at most
+// tol relative to |x| (absolute for |x| < 1).
+template <typename R, int i, typename T, Field X>
+pointwise_report solve_pointwise(const R& residual, const expr<autodiff::op::var<i>, T>& /*unknown*/, X&& x,
+                                 double tol, std::size_t max_iterations = 50) {
+    const std::size_t n = std::size(x);
+    assert(extent(residual) == n || extent(residual) == 0);
+
+    auto derivative = autodiff::derivative<i, std::remove_cvref_t<T>>(residual);
+    static_assert(!std::is_same_v<decltype(derivative), expr<autodiff::not_dependent>>,
+                  "The residual does not depend on the unknown");
+
+    auto r = transform_matching(residual, tr::substitute_var<i, std::remove_reference_t<X>>{x});
+    auto dr = transform_matching(derivative, tr::substitute_var<i, std::remove_reference_t<X>>{x});
+    decltype(auto) fr = fold_constants(r);
+    decltype(auto) hr = hoist_invariants(fr);
+    decltype(auto) fd = fold_constants(dr);
+    decltype(auto) hd = hoist_invariants(fd);
+
+    pointwise_report report;
+    for (std::size_t begin = 0; begin < n; begin += pointwise_lanes) {
+        const std::size_t w = std::min(pointwise_lanes, n - begin);
+        report.iterations = std::max(report.iterations,
+            detail::newton_block(x, hr, hd, begin, w, tol, max_iterations, report.unconverged));
+    }
+    return report;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "array.hpp"
+#include "cost.hpp"
+#include "profile.hpp"
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Non-temporal stores for assignments whose destination is not read again
+// soon. They write around the cache, which saves the read for ownership of
+// every destination cache line and keeps the inputs of the following kernels
+// in cache. Used for float and double fields with contiguous storage on
+// x86 (SSE2); other destinations are assigned with normal stores.
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// roughly the size of a last level cache, destinations larger than this do
+// not stay in cache anyway
+inline constexpr std::size_t large_field_bytes = std::size_t{32} << 20;
+
+// Store policy for et::assign. By default non-temporal stores are used only
+// for destinations of at least large_field_bytes, min_bytes = 0 uses them
+// always.
+struct nontemporal_stores {
+    std::size_t min_bytes = large_field_bytes;
+};
+
+namespace detail {
+
+template <typename Dst>
+concept NontemporalDestination = Field<Dst> && requires (Dst& d) {
+    { std::data(d) } -> std::same_as<field_element_t<Dst>*>;
+} && (std::same_as<field_element_t<Dst>, float> || std::same_as<field_element_t<Dst>, double>);
+
+template <typename Dst, typename E>
+bool use_nontemporal(const Dst& dst, const E& e, nontemporal_stores policy) {
+#if defined(__SSE2__)
+    if constexpr (NontemporalDestination<Dst>) {
+        return std::size(dst) * sizeof(field_element_t<Dst>) >= policy.min_bytes
+            && plan_assign(dst, e).strategy == assign_strategy::forward;
+    }
+#endif
+    (void)dst;
+    (void)e;
+    (void)policy;
+    return false;
+}
+
+#if defined(__SSE2__)
+
+template <typename Dst, typename E>
+void assign_nontemporal_loop(Dst& dst, const E& e, std::size_t n) {
+    using T = field_element_t<Dst>;
+    constexpr std::size_t lanes = 16 / sizeof(T);
+    T* p = std::data(dst);
+
+    // normal stores up to the first 16-byte boundary
+    std::size_t i = 0;
+    for (; i < n && reinterpret_cast<std::uintptr_t>(p + i) % 16 != 0; ++i) {
+        p[i] = evaluate_at(e, i);
+    }
+    for (; i + lanes <= n; i += lanes) {
+        T v[lanes];
+        for (std::size_t k = 0; k < lanes; ++k) {
+            v[k] = evaluate_at(e, i + k);
+        }
+        if constexpr (std::is_same_v<T, double>) {
+            _mm_stream_pd(p + i, _mm_loadu_pd(v));
+        }
+        else {
+            _mm_stream_ps(p + i, _mm_loadu_ps(v));
+        }
+    }
+    // make the non-temporal stores visible before any later store
+    _mm_sfence();
+    for (; i < n; ++i) {
+        p[i] = evaluate_at(e, i);
+    }
+}
+
+#endif
+
+template <typename Dst, typename E>
+void assign_stores(Dst& dst, const E& e, std::size_t n, nontemporal_stores policy) {
+#if defined(__SSE2__)
+    if constexpr (NontemporalDestination<Dst>) {
+        if (use_nontemporal(dst, e, policy)) {
+            assign_nontemporal_loop(dst, e, n);
+            return;
+        }
+    }
+#endif
+    (void)policy;
+    assign_dispatch(dst, e, n);
+}
+
+} // namespace detail
+
+template <Field Dst, typename E>
+void assign(Dst&& dst, const E& e, nontemporal_stores policy) {
+    const std::size_t n = std::size(dst);
+    assert(extent(e) == n || extent(e) == 0);
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+#ifdef ET_PROFILE
+    constexpr cost c = assign_cost_v<std::remove_cvref_t<Dst>, std::remove_cvref_t<decltype(h)>>;
+    detail::timed(profile::kernel_entry<profile::assign_kernel, E>(), c, n, [&] { detail::assign_stores(dst, h, n, policy); });
+#else
+    detail::assign_stores(dst, h, n, policy);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
@@ -68,10 +68,10 @@ constexpr decltype(auto) operator()(E&& e) {
     using E1 = std::remove_cvref_t<E>;
     if constexpr (Expr<E1>) {
         if constexpr (et::detail::arity<E1> == 0) {
-            return std::tuple<>();
+            return terminals{}(e.arg);
         }
         else if constexpr (et::detail::arity<E1> == 1) {
-            return terminals{}(e.arg);
+            return terminals{}(e.arg1);
         }
         else if constexpr (et::detail::arity<E1> == 2) {
             return std::tuple_cat(terminals{}(e.arg1), terminals{}(e.arg2));
@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "expr.hpp"
+#include "cost.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Polynomial nodes, coefficients in ascending order c0 + c1 x + c2 x^2 + ...
+//     et::poly(T, a1, a2, a3, a4, a5)      // coefficients stored in the node
+//     et::poly<1.0, 0.5, 0.25>(x)          // compile-time coefficients
+//     et::piecewise_poly(T, breaks, coeffs) // e.g. NASA-7 low and high range
+// Low degrees are evaluated with Horner's scheme, from degree
+// estrin_min_degree on with Estrin's scheme, whose independent products
+// shorten the dependency chain to ceil(log2(degree + 1)) multiply-adds.
+// Multiply-adds are fused when the target has FMA instructions.
+// The derivative of a polynomial node is a polynomial node, so autodiff and
+// solve_pointwise apply to them.
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline constexpr std::size_t estrin_min_degree = 4;
+
+namespace detail {
+
+#ifdef FP_FAST_FMA
+inline constexpr bool has_fast_fma_double = true;
+#else
+inline constexpr bool has_fast_fma_double = false;
+#endif
+
+#ifdef FP_FAST_FMAF
+inline constexpr bool has_fast_fma_float = true;
+#else
+inline constexpr bool has_fast_fma_float = false;
+#endif
+
+// a * b + c, rounded once if the target has FMA instructions
+template <typename T>
+constexpr T mul_add(T a, T b, T c) {
+    if constexpr ((std::is_same_v<T, double> && has_fast_fma_double) || (std::is_same_v<T, float> && has_fast_fma_float)) {
+        if (!std::is_constant_evaluated()) {
+            return std::fma(a, b, c);
+        }
+    }
+    return a * b + c;
+}
+
+template <typename R, typename T, std::size_t N>
+constexpr std::array<R, N> convert(const std::array<T, N>& c) {
+    return [&] <std::size_t... k> (std::index_sequence<k...>) {
+        return std::array<R, N>{static_cast<R>(c[k])...};
+    }(std::make_index_sequence<N>{});
+}
+
+// coefficients of the derivative, a constant has the derivative 0
+template <typename T, std::size_t N>
+constexpr auto derivative_coefficients(const std::array<T, N>& c) {
+    if constexpr (N <= 1) {
+        return std::array<T, 1>{};
+    }
+    else {
+        return [&] <std::size_t... k> (std::index_sequence<k...>) {
+            return std::array<T, N - 1>{static_cast<T>((k + 1) * c[k + 1])...};
+        }(std::make_index_sequence<N - 1>{});
+    }
+}
+
+// multiply-adds of the scheme, squarings of Estrin's scheme counted as mul
+template <std::size_t N>
+constexpr cost poly_cost() {
+    if constexpr (N <= 1) {
+        return {};
+    }
+    else if constexpr (N - 1 < estrin_min_degree) {
+        return {.add = N - 1, .mul = N - 1};
+    }
+    else {
+        cost c;
+        for (std::size_t n = N; n > 1; n = (n + 1) / 2) {
+            c.add += n / 2;
+            c.mul += n / 2 + ((n + 1) / 2 > 1);
+        }
+        return c;
+    }
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename X, typename T, std::size_t N>
+    requires (N > 0)
+constexpr auto horner(X x, const std::array<T, N>& c) {
+    using R = std::common_type_t<X, T>;
+    R r = static_cast<R>(c[N - 1]);
+    for (std::size_t k = N - 1; k-- > 0;) {
+        r = detail::mul_add(r, static_cast<R>(x), static_cast<R>(c[k]));
+    }
+    return r;
+}
+
+// pairs of coefficients are combined with x, pairs of pairs with x^2, ...
+template <typename X, typename T, std::size_t N>
+    requires (N > 0)
+constexpr auto estrin(X x, const std::array<T, N>& c) {
+    using R = std::common_type_t<X, T>;
+    if constexpr (N == 1) {
+        return static_cast<R>(c[0]);
+    }
+    else {
+        std::array<R, (N + 1) / 2> p{};
+        for (std::size_t k = 0; k < N / 2; ++k) {
+            p[k] = detail::mul_add(static_cast<R>(c[2 * k + 1]), static_cast<R>(x), static_cast<R>(c[2 * k]));
+        }
+        if constexpr (N % 2 == 1) {
+            p[N / 2] = static_cast<R>(c[N - 1]);
+        }
+        return estrin(static_cast<R>(x) * static_cast<R>(x), p);
+    }
+}
+
+// scheme picked by the degree
+template <typename X, typename T, std::size_t N>
+    requires (N > 0)
+constexpr auto polyval(X x, const std::array<T, N>& c) {
+    if constexpr (N - 1 < estrin_min_degree) {
+        return horner(x, c);
+    }
+    else {
+        return estrin(x, c);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace op {
+
+template <typename T, std::size_t N>
+struct poly {
+    std::array<T, N> c;
+
+    template <typename X>
+    constexpr auto operator()(const X& x) const {
+        return polyval(x, c);
+    }
+};
+
+template <auto... c>
+struct static_poly {
+    static constexpr std::array<std::common_type_t<decltype(c)...>, sizeof...(c)> coefficients = {c...};
+
+    template <typename X>
+    constexpr auto operator()(const X& x) const {
+        return polyval(x, coefficients);
+    }
+};
+
+// M polynomials of N coefficients, polynomial m applies from breaks[m - 1]
+// on; the first and the last one extrapolate. breaks must be ascending. The
+// coefficients are selected by M - 1 comparisons and blends instead of an
+// indexed load, which vectorises for the few intervals of thermodynamic fits.
+template <typename T, std::size_t N, std::size_t M>
+struct piecewise_poly {
+    std::array<T, M - 1> breaks;
+    std::array<std::array<T, N>, M> c;
+
+    template <typename X>
+    constexpr auto operator()(const X& x) const {
+        using R = std::common_type_t<X, T>;
+        std::array<R, N> a = detail::convert<R>(c[0]);
+        for (std::size_t m = 1; m < M; ++m) {
+            const bool above = !(x < breaks[m - 1]);
+            for (std::size_t k = 0; k < N; ++k) {
+                a[k] = above ? static_cast<R>(c[m][k]) : a[k];
+            }
+        }
+        return polyval(static_cast<R>(x), a);
+    }
+};
+
+// derivatives, found by autodiff through argument-dependent lookup
+
+template <typename T, std::size_t N, typename Arg>
+constexpr auto unary_function_derivative(const poly<T, N>& p, Arg&& arg) {
+    auto d = detail::derivative_coefficients(p.c);
+    return expr(poly<T, std::tuple_size_v<decltype(d)>>{d}, std::forward<Arg>(arg));
+}
+
+template <auto... c, typename Arg>
+constexpr auto unary_function_derivative(const static_poly<c...>& /*p*/, Arg&& arg) {
+    constexpr auto d = detail::derivative_coefficients(static_poly<c...>::coefficients);
+    return expr(poly<typename decltype(d)::value_type, std::tuple_size_v<decltype(d)>>{d}, std::forward<Arg>(arg));
+}
+
+template <typename T, std::size_t N, std::size_t M, typename Arg>
+constexpr auto unary_function_derivative(const piecewise_poly<T, N, M>& p, Arg&& arg) {
+    using D = decltype(detail::derivative_coefficients(p.c[0]));
+    piecewise_poly<T, std::tuple_size_v<D>, M> d{p.breaks, {}};
+    for (std::size_t m = 0; m < M; ++m) {
+        d.c[m] = detail::derivative_coefficients(p.c[m]);
+    }
+    return expr(std::move(d), std::forward<Arg>(arg));
+}
+
+} // namespace op
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <Expr X, typename... C>
+    requires (sizeof...(C) > 0 && (std::is_arithmetic_v<C> && ...))
+constexpr auto poly(X&& x, C... c) {
+    using T = std::common_type_t<C...>;
+    return expr(op::poly<T, sizeof...(C)>{{static_cast<T>(c)...}}, unwrap(std::forward<X>(x)));
+}
+
+template <Expr X, typename T, std::size_t N>
+    requires (N > 0)
+constexpr auto poly(X&& x, const std::array<T, N>& c) {
+    return expr(op::poly<T, N>{c}, unwrap(std::forward<X>(x)));
+}
+
+template <auto... c, Expr X>
+    requires (sizeof...(c) > 0)
+constexpr auto poly(X&& x) {
+    return expr(op::static_poly<c...>{}, unwrap(std::forward<X>(x)));
+}
+
+template <Expr X, typename T, std::size_t B, std::size_t N, std::size_t M>
+    requires (B + 1 == M && N > 0)
+constexpr auto piecewise_poly(X&& x, const std::array<T, B>& breaks, const std::array<std::array<T, N>, M>& c) {
+    return expr(op::piecewise_poly<T, N, M>{breaks, c}, unwrap(std::forward<X>(x)));
+}
+
+template <typename T, std::size_t N>
+inline constexpr std::string_view symbol_v<op::poly<T, N>> = "poly";
+
+template <auto... c>
+inline constexpr std::string_view symbol_v<op::static_poly<c...>> = "poly";
+
+template <typename T, std::size_t N, std::size_t M>
+inline constexpr std::string_view symbol_v<op::piecewise_poly<T, N, M>> = "piecewise_poly";
+
+template <typename T, std::size_t N>
+inline constexpr cost op_cost_v<op::poly<T, N>> = detail::poly_cost<N>();
+
+template <auto... c>
+inline constexpr cost op_cost_v<op::static_poly<c...>> = detail::poly_cost<sizeof...(c)>();
+
+// the blends of the coefficients are not counted
+template <typename T, std::size_t N, std::size_t M>
+inline constexpr cost op_cost_v<op::piecewise_poly<T, N, M>> = detail::poly_cost<N>();
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
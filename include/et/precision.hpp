@@ -0,0 +1,416 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "expr.hpp"
+#include "array.hpp"
+#include "cost.hpp"
+#include "task_graph.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Precision control of array evaluation.
+//
+// compute_in<T>(e) evaluates e with all terminals converted to T, so fields
+// can be stored in float while the arithmetic is done in double.
+// compensate_sums(e) evaluates chains of op::plus with error-free
+// transformations, and sum(e, init, policy) selects compensated or pairwise
+// summation for reductions. Compensated summation does not survive
+// -ffast-math or -fassociative-math.
+//
+// reproducible_summation gives the same bits for any number of threads: the
+// elements are summed in blocks of fixed size, each in a fixed number of
+// interleaved lanes, and the block sums are added in a fixed pairwise tree.
+// The order of additions depends only on the number of elements and the
+// block size. Bitwise equality across targets also needs the same rounding
+// of the summed values, i.e. -ffp-contract=off when the targets differ in
+// FMA support, and no -ffast-math.
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// sum + error, where error is the rounding error of sum
+template <typename T>
+struct compensated {
+    T sum{};
+    T error{};
+};
+
+namespace detail {
+
+template <typename T>
+constexpr const T& sum_of(const T& x) {
+    return x;
+}
+
+template <typename T>
+constexpr const T& sum_of(const compensated<T>& x) {
+    return x.sum;
+}
+
+template <typename T>
+constexpr T error_of(const T& /*x*/) {
+    return T{};
+}
+
+template <typename T>
+constexpr const T& error_of(const compensated<T>& x) {
+    return x.error;
+}
+
+// Knuth's TwoSum: s + e == a + b exactly
+template <typename T>
+constexpr compensated<T> two_sum(T a, T b) {
+    T s = a + b;
+    T bb = s - a;
+    T e = (a - (s - bb)) + (b - bb);
+    return {s, e};
+}
+
+} // namespace detail
+
+namespace op {
+
+template <typename T>
+struct convert {
+    template <typename U>
+    constexpr T operator()(const U& x) const {
+        return static_cast<T>(x);
+    }
+};
+
+// op::plus on compensated values. Errors are accumulated separately, so a
+// small term survives cancellation of large ones (Neumaier).
+struct compensated_plus {
+    template <typename A, typename B>
+    constexpr auto operator()(const A& a, const B& b) const {
+        using T = std::common_type_t<std::remove_cvref_t<decltype(detail::sum_of(a))>,
+                                     std::remove_cvref_t<decltype(detail::sum_of(b))>>;
+        compensated<T> r = detail::two_sum<T>(detail::sum_of(a), detail::sum_of(b));
+        r.error += detail::error_of(a) + detail::error_of(b);
+        return r;
+    }
+};
+
+// Kahan's running sum: the error of the previous addition is added to the
+// next operand, so it stays below one ulp of the sum
+struct kahan_plus {
+    template <typename T, typename U>
+    constexpr compensated<T> operator()(const compensated<T>& acc, const U& x) const {
+        T y = static_cast<T>(x) + acc.error;
+        T s = acc.sum + y;
+        return {s, y - (s - acc.sum)};
+    }
+};
+
+// rounds a compensated value to its type
+struct compensated_round {
+    template <typename T>
+    constexpr T operator()(const compensated<T>& x) const {
+        return x.sum + x.error;
+    }
+};
+
+} // namespace op
+
+template <typename T> inline constexpr cost op_cost_v<op::convert<T>> = {.other = 1};
+template <> inline constexpr cost op_cost_v<op::compensated_plus> = {.add = 8};
+template <> inline constexpr cost op_cost_v<op::kahan_plus> = {.add = 4};
+template <> inline constexpr cost op_cost_v<op::compensated_round> = {.add = 1};
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+// integer and bool terminals keep their type, so % and masks still work
+template <typename T>
+inline constexpr bool is_convertible_terminal = std::is_floating_point_v<T>;
+
+template <Field F>
+inline constexpr bool is_convertible_terminal<F> = std::is_floating_point_v<field_element_t<F>>;
+
+// keeps a terminal as it was stored in the source expression: references
+// as const references, values by copy
+template <typename Stored, typename T>
+constexpr std::conditional_t<std::is_reference_v<Stored>, const T&, T> keep(const T& t) {
+    return t;
+}
+
+} // namespace detail
+
+namespace tr {
+
+// Converts every floating-point terminal to T on load. Used with
+// transform_matching.
+template <typename T>
+struct compute_in {
+    template <typename U>
+        requires (!Expr<U> && et::detail::is_convertible_terminal<U>)
+    constexpr auto operator()(const U& t) const {
+        return convert<const U&>(t);
+    }
+
+    template <typename Arg>
+    constexpr auto operator()(const expr<Arg>& e) const {
+        using U = std::remove_cvref_t<Arg>;
+        if constexpr (!et::detail::is_convertible_terminal<U>) {
+            return detail::copy(e);
+        }
+        else if constexpr (Field<U>) {
+            return convert<Arg>(e.arg);
+        }
+        else {
+            return expr(convert<Arg>(e.arg));
+        }
+    }
+
+    template <typename Op, typename Arg1>
+    constexpr auto operator()(const expr<Op, Arg1>& e) const {
+        return expr(detail::copy(e.op), link<Arg1>(e.arg1));
+    }
+
+    template <typename Op, typename Arg1, typename Arg2>
+    constexpr auto operator()(const expr<Op, Arg1, Arg2>& e) const {
+        return expr(detail::copy(e.op), link<Arg1>(e.arg1), link<Arg2>(e.arg2));
+    }
+
+    template <typename Op, typename Arg1, typename Arg2, typename Arg3>
+    constexpr auto operator()(const expr<Op, Arg1, Arg2, Arg3>& e) const {
+        return expr(detail::copy(e.op), link<Arg1>(e.arg1), link<Arg2>(e.arg2), link<Arg3>(e.arg3));
+    }
+
+private:
+    // terminals stored by value are copied, the source expression may be a temporary
+    template <typename Stored, typename U>
+    constexpr decltype(auto) link(const U& t) const {
+        if constexpr (Expr<U>) {
+            return transform_matching(t, *this);
+        }
+        else if constexpr (et::detail::is_convertible_terminal<U>) {
+            return convert<Stored>(t);
+        }
+        else {
+            return et::detail::keep<Stored>(t);
+        }
+    }
+
+    template <typename Stored, typename U>
+    constexpr auto convert(const U& t) const {
+        if constexpr (Field<U>) {
+            return expr(op::convert<T>{}, et::detail::keep<Stored>(t));
+        }
+        else {
+            return static_cast<T>(t);
+        }
+    }
+};
+
+// Replaces every chain of op::plus by compensated additions, rounded once
+// at the top of the chain. Used with transform_matching.
+struct compensate_sums {
+    template <typename Arg1, typename Arg2>
+    constexpr auto operator()(const expr<op::plus, Arg1, Arg2>& e) const {
+        return expr(op::compensated_round{}, chain(e));
+    }
+
+private:
+    template <typename Arg1, typename Arg2>
+    constexpr auto chain(const expr<op::plus, Arg1, Arg2>& e) const {
+        return expr(op::compensated_plus{}, link<Arg1>(e.arg1), link<Arg2>(e.arg2));
+    }
+
+    template <typename Stored, typename T>
+    constexpr decltype(auto) link(const T& t) const {
+        if constexpr (Expr<T>) {
+            if constexpr (requires { chain(t); }) {
+                return chain(t);
+            }
+            else {
+                // operands of other operations may contain chains of their own
+                return detail::copy(transform_matching(t, *this));
+            }
+        }
+        else {
+            return et::detail::keep<Stored>(t);
+        }
+    }
+};
+
+} // namespace tr
+
+template <typename T, typename E>
+constexpr decltype(auto) compute_in(const E& e) {
+    return transform_matching(e, tr::compute_in<T>{});
+}
+
+template <typename E>
+constexpr decltype(auto) compensate_sums(const E& e) {
+    return transform_matching(e, tr::compensate_sums{});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Summation policies for et::sum
+
+// compensated summation, error bound independent of the number of elements
+struct kahan_summation {};
+
+// recursive halving down to blocks summed in order, error grows as log(n)
+struct pairwise_summation {
+    std::size_t block = 128;
+};
+
+template <typename E, typename T>
+T sum(const E& e, T init, kahan_summation) {
+    return op::compensated_round{}(reduce(e, compensated<T>{init, T{}}, op::kahan_plus{}));
+}
+
+namespace detail {
+
+template <typename E, typename T>
+T pairwise_sum(const E& e, std::size_t begin, std::size_t end, std::size_t block) {
+    if (end - begin <= block) {
+        T s{};
+        for (std::size_t i = begin; i < end; ++i) {
+            s += static_cast<T>(evaluate_at(e, i));
+        }
+        return s;
+    }
+    std::size_t mid = begin + (end - begin) / 2;
+    return pairwise_sum<E, T>(e, begin, mid, block) + pairwise_sum<E, T>(e, mid, end, block);
+}
+
+} // namespace detail
+
+template <typename E, typename T>
+T sum(const E& e, T init, pairwise_summation policy) {
+    const std::size_t n = extent(e);
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+    using H = std::remove_cvref_t<decltype(h)>;
+    return detail::profiled<profile::reduce_kernel, E>(cost_v<H> + op_cost_v<op::plus>, n, [&] {
+        return init + detail::pairwise_sum<H, T>(h, 0, n, std::max<std::size_t>(policy.block, 1));
+    });
+}
+
+// fixed order of additions, independent of the number of threads
+struct reproducible_summation {
+    std::size_t block = 1024;
+};
+
+namespace detail {
+
+// independent accumulators of a block, a multiple of the SIMD width of the
+// targets so that the lanes vectorise without reassociation
+inline constexpr std::size_t reproducible_lanes = 16;
+
+template <typename T, typename E>
+T reproducible_block_sum(const E& e, std::size_t begin, std::size_t end) {
+    constexpr std::size_t L = reproducible_lanes;
+    T acc[L] = {};
+    std::size_t i = begin;
+    for (; i + L <= end; i += L) {
+        for (std::size_t k = 0; k < L; ++k) {
+            acc[k] += static_cast<T>(evaluate_at(e, i + k));
+        }
+    }
+    for (std::size_t k = 0; i < end; ++i, ++k) {
+        acc[k] += static_cast<T>(evaluate_at(e, i));
+    }
+    for (std::size_t w = L / 2; w > 0; w /= 2) {
+        for (std::size_t k = 0; k < w; ++k) {
+            acc[k] += acc[k + w];
+        }
+    }
+    return acc[0];
+}
+
+// pairwise sum of the blocks [begin, end), block(b) gives the sum of block b
+template <typename T, typename Block>
+T reproducible_tree(const Block& block, std::size_t begin, std::size_t end) {
+    if (end - begin == 1) {
+        return block(begin);
+    }
+    std::size_t mid = begin + (end - begin) / 2;
+    return reproducible_tree<T>(block, begin, mid) + reproducible_tree<T>(block, mid, end);
+}
+
+} // namespace detail
+
+template <typename E, typename T>
+T sum(const E& e, T init, reproducible_summation policy) {
+    const std::size_t n = extent(e);
+    const std::size_t block = std::max<std::size_t>(policy.block, 1);
+    if (n == 0) {
+        return init;
+    }
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+    auto block_sum = [&] (std::size_t b) {
+        return detail::reproducible_block_sum<T>(h, b * block, std::min(n, (b + 1) * block));
+    };
+    return detail::profiled<profile::reduce_kernel, E>(cost_v<std::remove_cvref_t<decltype(h)>> + op_cost_v<op::plus>, n, [&] {
+        return init + detail::reproducible_tree<T>(block_sum, 0, (n + block - 1) / block);
+    });
+}
+
+// Same result as above, the blocks are summed by the threads of pool
+template <typename E, typename T>
+T sum(const E& e, T init, reproducible_summation policy, thread_pool& pool) {
+    const std::size_t n = extent(e);
+    const std::size_t block = std::max<std::size_t>(policy.block, 1);
+    if (n == 0) {
+        return init;
+    }
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+    using H = std::remove_cvref_t<decltype(h)>;
+
+    const std::size_t blocks = (n + block - 1) / block;
+    // a few jobs per thread for load balance
+    const std::size_t jobs = std::min<std::size_t>(blocks, 4 * std::max(pool.size(), 1u));
+    const std::size_t per_job = (blocks + jobs - 1) / jobs;
+    std::vector<T> partial(blocks);
+
+    struct context {
+        const H& h;
+        T* partial;
+        std::size_t n;
+        std::size_t block;
+        std::size_t blocks;
+        std::size_t per_job;
+        std::atomic<std::size_t> remaining;
+    } ctx{h, partial.data(), n, block, blocks, per_job, jobs};
+
+    auto run = [] (void* c, std::size_t job) {
+        context& x = *static_cast<context*>(c);
+        const std::size_t last = std::min(x.blocks, (job + 1) * x.per_job);
+        for (std::size_t b = job * x.per_job; b < last; ++b) {
+            x.partial[b] = detail::reproducible_block_sum<T>(x.h, b * x.block, std::min(x.n, (b + 1) * x.block));
+        }
+        x.remaining.fetch_sub(1);
+    };
+    return detail::profiled<profile::reduce_kernel, E>(cost_v<H> + op_cost_v<op::plus>, n, [&] {
+        for (std::size_t j = 0; j < jobs; ++j) {
+            pool.submit({run, &ctx, j});
+        }
+        // waits for these jobs only, the caller may itself be a job of pool
+        pool.wait(ctx.remaining);
+
+        return init + detail::reproducible_tree<T>([&] (std::size_t b) { return partial[b]; }, 0, blocks);
+    });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
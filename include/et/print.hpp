@@ -63,11 +63,11 @@ struct print {
     template<typename Op, typename Arg1, typename Arg2, typename Arg3>
     bool operator()(const expr<Op, Arg1, Arg2, Arg3> &e) const {
         return  (stream << symbol_v<Op> << '(')
-               && print{stream}(e.arg1)
+               && print<>{stream}(e.arg1)
                && (stream << ", ")
-               && print{stream}(e.arg2)
+               && print<>{stream}(e.arg2)
                && (stream << ", ")
-               && print{stream}(e.arg3)
+               && print<>{stream}(e.arg3)
                && (stream << ')');
     }
 
@@ -90,9 +90,9 @@ struct print {
         }
         else {
             return  (stream << symbol_v<Op> << '(')
-                   && print{stream}(e.arg1)
+                   && print<>{stream}(e.arg1)
                    && (stream << ", ")
-                   && print{stream}(e.arg2)
+                   && print<>{stream}(e.arg2)
                    && (stream << ')');
         }
     }
@@ -105,7 +105,7 @@ struct print {
         }
         else {
             return  (stream << symbol_v<Op> << '(')
-                   && print{stream}(e.arg1)
+                   && print<>{stream}(e.arg1)
                    && (stream << ')');
         }
     }
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "cost.hpp"
+#include "type_name.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Per-kernel profiling of array evaluations.
+//
+// When ET_PROFILE is defined (cmake -DET_PROFILE=ON), every call to
+// et::assign and et::reduce is timed and accumulated in a global registry
+// keyed by the expression type. Without it nothing is recorded and array
+// evaluation has no overhead.
+
+namespace et::profile {
+
+inline constexpr bool enabled =
+#ifdef ET_PROFILE
+    true;
+#else
+    false;
+#endif
+
+struct entry {
+    std::string_view kind;
+    std::string_view name;
+    std::uint64_t hash = 0;
+    eval_stats stats;
+
+    // thread safe
+    void add(const cost& c, std::size_t n, double seconds);
+};
+
+struct assign_kernel {
+    static constexpr std::string_view name = "assign";
+};
+
+struct reduce_kernel {
+    static constexpr std::string_view name = "reduce";
+};
+
+entry& register_kernel(std::string_view kind, std::string_view name, std::uint64_t hash);
+
+// Registry entry for kernels of the given kind evaluating expression E
+template <typename Kind, typename E>
+entry& kernel_entry() {
+    static entry& e = register_kernel(Kind::name, get_type_name<E>(), get_type_hash<E>());
+    return e;
+}
+
+// Copy of all entries, sorted by total time, largest first
+std::vector<entry> snapshot();
+
+// Clears accumulated statistics, registered kernels are kept
+void reset();
+
+std::ostream& write_json(std::ostream& s);
+std::ostream& write_csv(std::ostream& s);
+
+// Writes the report to the file at program exit, CSV if the file name ends
+// with ".csv", JSON otherwise. An empty path disables the report.
+void report_at_exit(std::string path);
+
+} // namespace et::profile
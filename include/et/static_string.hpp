@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "expr.hpp"
+#include "fold.hpp"
+#include "placeholders.hpp"
+#include "print.hpp"
+#include "type_name.hpp"
+
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Compile-time rendering of an expression type, in the same format as
+// tr::print. Terminals of arithmetic types and floating-point constants are
+// rendered as "{}" and filled in at runtime by et::format_to, integral
+// constants are rendered in place, all other terminals as <type name>.
+
+namespace detail {
+
+template <typename T>
+constexpr bool is_floating_constant() {
+    if constexpr (is_constant_v<T>) {
+        return std::floating_point<std::remove_cvref_t<decltype(T::value)>>;
+    }
+    else {
+        return false;
+    }
+}
+
+// floating-point constants are formatted like runtime values, there is no
+// constexpr std::to_chars for them
+template <typename T>
+inline constexpr bool is_formatted_terminal = std::is_arithmetic_v<T> || is_floating_constant<T>();
+
+template <typename T>
+constexpr auto terminal_value(const T& t) {
+    if constexpr (is_constant_v<T>) {
+        return T::value;
+    }
+    else {
+        return t;
+    }
+}
+
+// the text std::ostream writes with the default flags: %g with precision 6
+// for floating point values
+template <typename T>
+std::to_chars_result to_chars_like_print(char* first, char* last, T value) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::to_chars(first, last, value, std::chars_format::general, 6);
+    }
+    else {
+        return std::to_chars(first, last, value);
+    }
+}
+
+struct string_builder {
+    char* out = nullptr;
+    std::size_t size = 0;
+
+    constexpr void append(std::string_view s) {
+        for (char c : s) {
+            if (out) {
+                out[size] = c;
+            }
+            ++size;
+        }
+    }
+
+    template <std::integral T>
+    constexpr void append_integer(T value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            append(value ? "1" : "0");
+        }
+        else {
+            char digits[24] = {};
+            int n = 0;
+            bool negative = value < 0;
+            do {
+                int d = static_cast<int>(value % 10);
+                digits[n++] = static_cast<char>('0' + (d < 0 ? -d : d));
+                value /= 10;
+            } while (value != 0);
+            if (negative) {
+                append("-");
+            }
+            while (n > 0) {
+                append({&digits[--n], 1});
+            }
+        }
+    }
+};
+
+template <int priority, typename T>
+constexpr void build_static_string(string_builder& b, std::type_identity<T>) {
+    if constexpr (is_formatted_terminal<T>) {
+        b.append("{}");
+    }
+    else if constexpr (is_constant_v<T> && std::integral<std::remove_cvref_t<decltype(T::value)>>) {
+        b.append_integer(T::value);
+    }
+    else {
+        b.append("<");
+        b.append(get_type_name<T>());
+        b.append(">");
+    }
+}
+
+template <int priority, typename Arg>
+constexpr void build_static_string(string_builder& b, std::type_identity<expr<Arg>>) {
+    build_static_string<priority>(b, std::type_identity<std::remove_cvref_t<Arg>>{});
+}
+
+template <int priority, typename Op, typename Arg1>
+constexpr void build_static_string(string_builder& b, std::type_identity<expr<Op, Arg1>>) {
+    if constexpr (is_prefix_op_v<Op>) {
+        b.append(symbol_v<Op>);
+        build_static_string<op_priority<Op>>(b, std::type_identity<std::remove_cvref_t<Arg1>>{});
+    }
+    else {
+        b.append(symbol_v<Op>);
+        b.append("(");
+        build_static_string<17>(b, std::type_identity<std::remove_cvref_t<Arg1>>{});
+        b.append(")");
+    }
+}
+
+template <int priority, typename Op, typename Arg1, typename Arg2>
+constexpr void build_static_string(string_builder& b, std::type_identity<expr<Op, Arg1, Arg2>>) {
+    if constexpr (is_infix_op_v<Op>) {
+        constexpr int new_prio = op_priority<Op>;
+        if constexpr (new_prio >= priority) {
+            b.append("(");
+        }
+        build_static_string<new_prio>(b, std::type_identity<std::remove_cvref_t<Arg1>>{});
+        b.append(" ");
+        b.append(symbol_v<Op>);
+        b.append(" ");
+        build_static_string<new_prio>(b, std::type_identity<std::remove_cvref_t<Arg2>>{});
+        if constexpr (new_prio >= priority) {
+            b.append(")");
+        }
+    }
+    else {
+        b.append(symbol_v<Op>);
+        b.append("(");
+        build_static_string<17>(b, std::type_identity<std::remove_cvref_t<Arg1>>{});
+        b.append(", ");
+        build_static_string<17>(b, std::type_identity<std::remove_cvref_t<Arg2>>{});
+        b.append(")");
+    }
+}
+
+template <int priority, typename Op, typename Arg1, typename Arg2, typename Arg3>
+constexpr void build_static_string(string_builder& b, std::type_identity<expr<Op, Arg1, Arg2, Arg3>>) {
+    b.append(symbol_v<Op>);
+    b.append("(");
+    build_static_string<17>(b, std::type_identity<std::remove_cvref_t<Arg1>>{});
+    b.append(", ");
+    build_static_string<17>(b, std::type_identity<std::remove_cvref_t<Arg2>>{});
+    b.append(", ");
+    build_static_string<17>(b, std::type_identity<std::remove_cvref_t<Arg3>>{});
+    b.append(")");
+}
+
+// make an array containing the rendered expression, not null-terminated
+template <typename E>
+constexpr auto make_static_string() {
+    constexpr std::size_t len = [] {
+        string_builder b;
+        build_static_string<17>(b, std::type_identity<E>{});
+        return b.size;
+    }();
+    std::array<char, len> ret{};
+    string_builder b{ret.data()};
+    build_static_string<17>(b, std::type_identity<E>{});
+    return ret;
+}
+
+template <typename E>
+constexpr inline auto static_string_array = make_static_string<E>();
+
+} // namespace detail
+
+template <typename E>
+constexpr std::string_view to_static_string() {
+    using E1 = std::remove_cvref_t<E>;
+    return {detail::static_string_array<E1>.data(), detail::static_string_array<E1>.size()};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Writes the expression into [first, last) without allocating, formatting
+// arithmetic terminals with std::to_chars in the format of tr::print. On
+// overflow returns {last, std::errc::value_too_large}.
+template <typename E>
+std::to_chars_result format_to(char* first, char* last, const E& e) {
+    constexpr std::string_view pattern = to_static_string<E>();
+    std::size_t pos = 0;
+    std::to_chars_result r{first, std::errc{}};
+
+    auto write_text = [&] (std::string_view s) {
+        if (static_cast<std::size_t>(last - r.ptr) < s.size()) {
+            r = {last, std::errc::value_too_large};
+            return;
+        }
+        for (char c : s) {
+            *r.ptr++ = c;
+        }
+    };
+
+    auto write_terminal = [&] <typename T> (const T& t) {
+        if constexpr (detail::is_formatted_terminal<T>) {
+            if (r.ec != std::errc{}) {
+                return;
+            }
+            std::size_t hole = pattern.find("{}", pos);
+            write_text(pattern.substr(pos, hole - pos));
+            pos = hole + 2;
+            if (r.ec != std::errc{}) {
+                return;
+            }
+            if constexpr (std::is_same_v<T, bool>) {
+                write_text(t ? "1" : "0");
+            }
+            else {
+                r = detail::to_chars_like_print(r.ptr, last, detail::terminal_value(t));
+            }
+        }
+    };
+
+    std::apply([&] (const auto&... t) { (write_terminal(t), ...); }, tr::terminals{}(e));
+    if (r.ec == std::errc{}) {
+        write_text(pattern.substr(pos));
+    }
+    return r;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
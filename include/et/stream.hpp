@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "array.hpp"
+#include "placeholders.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Out-of-core evaluation.
+//
+// mapped_field is a field stored in a memory-mapped file. Evaluation with
+// a streaming policy walks the index space in chunks; before a chunk is
+// computed, the kernel is asked to read ahead the next one, and the pages of
+// finished chunks are dropped from the process, so fields larger than the
+// memory are processed at disk bandwidth.
+//
+// file_sink is an output written sequentially by a background thread, so
+// that results never need a buffer of the full size.
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+class mapped_file {
+public:
+    enum class access { read_only, read_write };
+
+    mapped_file() = default;
+    // maps the whole file
+    mapped_file(const std::filesystem::path& path, access mode);
+    // creates or truncates the file to size bytes and maps it for writing
+    mapped_file(const std::filesystem::path& path, std::size_t size);
+    ~mapped_file();
+
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+
+    std::byte* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+    // hints for the byte range [begin, end), no-ops where unsupported
+    void will_need(std::size_t begin, std::size_t end) const;
+    void dont_need(std::size_t begin, std::size_t end) const;
+
+private:
+    std::byte* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+} // namespace detail
+
+// Field of trivially copyable elements stored in a file in native byte
+// order. mapped_field<const T> maps the file read only.
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+class mapped_field {
+public:
+    using value_type = std::remove_const_t<T>;
+
+    // maps an existing file
+    explicit mapped_field(const std::filesystem::path& path)
+        : file_(path, std::is_const_v<T> ? detail::mapped_file::access::read_only : detail::mapped_file::access::read_write)
+    {
+        assert(file_.size() % sizeof(T) == 0);
+    }
+
+    // creates a file of n elements
+    mapped_field(const std::filesystem::path& path, std::size_t n)
+        requires (!std::is_const_v<T>)
+        : file_(path, n * sizeof(T))
+    {
+    }
+
+    T& operator[](std::size_t i) const {
+        return reinterpret_cast<T*>(file_.data())[i];
+    }
+
+    std::size_t size() const {
+        return file_.size() / sizeof(T);
+    }
+
+    T* data() const {
+        return reinterpret_cast<T*>(file_.data());
+    }
+
+    // streaming hooks, see et::streaming
+    void prefetch(std::size_t begin, std::size_t end) const {
+        file_.will_need(begin * sizeof(T), end * sizeof(T));
+    }
+
+    void evict(std::size_t begin, std::size_t end) const {
+        file_.dont_need(begin * sizeof(T), end * sizeof(T));
+    }
+
+private:
+    detail::mapped_file file_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Evaluation policy: process the index space in chunks of the given number
+// of elements, prefetching the next chunk of every terminal that supports it
+struct streaming {
+    std::size_t chunk = std::size_t{1} << 20;
+};
+
+namespace detail {
+
+template <typename T>
+concept Prefetchable = requires (const T& t, std::size_t i) {
+    t.prefetch(i, i);
+    t.evict(i, i);
+};
+
+template <typename T>
+void prefetch_chunk(const T& t, std::size_t begin, std::size_t end) {
+    if constexpr (Prefetchable<T>) {
+        if (begin < end) {
+            t.prefetch(begin, end);
+        }
+    }
+}
+
+template <typename T>
+void evict_chunk(const T& t, std::size_t begin, std::size_t end) {
+    if constexpr (Prefetchable<T>) {
+        t.evict(begin, end);
+    }
+}
+
+// Calls f(begin, end) for consecutive chunks of [0, n). Terminals of e and
+// the extra fields are prefetched one chunk ahead and evicted behind.
+template <typename E, typename F, typename... Fields>
+void for_each_chunk(const E& e, std::size_t n, std::size_t chunk, F&& f, const Fields&... fields) {
+    assert(chunk > 0);
+    auto all = std::tuple_cat(tr::terminals{}(e), std::forward_as_tuple(fields...));
+    auto each = [&] (auto&& g) { std::apply([&] (const auto&... t) { (g(t), ...); }, all); };
+
+    each([&] (const auto& t) { prefetch_chunk(t, 0, std::min(chunk, n)); });
+    for (std::size_t begin = 0; begin < n; begin += chunk) {
+        const std::size_t end = std::min(begin + chunk, n);
+        each([&] (const auto& t) { prefetch_chunk(t, end, std::min(end + chunk, n)); });
+        f(begin, end);
+        each([&] (const auto& t) { evict_chunk(t, begin, end); });
+    }
+}
+
+} // namespace detail
+
+template <Field Dst, typename E>
+void assign(Dst&& dst, const E& e, streaming policy) {
+    const std::size_t n = std::size(dst);
+    assert(extent(e) == n || extent(e) == 0);
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+    constexpr cost c = assign_cost_v<std::remove_cvref_t<Dst>, std::remove_cvref_t<decltype(h)>>;
+    detail::profiled<profile::assign_kernel, E>(c, n, [&] {
+        if (detail::plan_assign(dst, h).strategy != detail::assign_strategy::forward) {
+            // the order of evaluation matters, leave it to the aliasing-aware loop
+            detail::assign_dispatch(dst, h, n);
+            return;
+        }
+        detail::for_each_chunk(h, n, policy.chunk, [&] (std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                dst[i] = evaluate_at(h, i);
+            }
+        }, dst);
+    });
+}
+
+template <typename E, typename T, typename Op>
+T reduce(const E& e, T init, Op op, streaming policy) {
+    const std::size_t n = extent(e);
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+    constexpr cost c = cost_v<std::remove_cvref_t<decltype(h)>> + apply_cost_v<Op, detail::shape_t<T>, detail::shape_t<decltype(h)>>;
+    detail::profiled<profile::reduce_kernel, E>(c, n, [&] {
+        detail::for_each_chunk(h, n, policy.chunk, [&] (std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                init = op(std::move(init), evaluate_at(h, i));
+            }
+        });
+    });
+    return init;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+// Writes a file from a background thread using two buffers: one is filled
+// by the caller while the other one is written.
+class async_writer {
+public:
+    async_writer(const std::filesystem::path& path, std::size_t buffer_bytes);
+    ~async_writer();
+
+    async_writer(const async_writer&) = delete;
+    async_writer& operator=(const async_writer&) = delete;
+
+    // free buffer, waits until the writer is done with it
+    std::span<std::byte> acquire();
+
+    // queues the first bytes of the buffer returned by acquire
+    void submit(std::size_t bytes);
+
+    // waits for all writes, closes the file and throws if a write failed
+    void close();
+
+private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+} // namespace detail
+
+// Output file of elements of type T in native byte order, e.g.
+//     et::file_sink<float> out("vorticity.bin");
+//     et::assign(out, magnitude(curl));
+// Each assignment appends extent(e) elements.
+template <typename T>
+    requires std::is_trivially_copyable_v<T> && (alignof(T) <= alignof(std::max_align_t))
+class file_sink {
+public:
+    explicit file_sink(const std::filesystem::path& path, std::size_t chunk = std::size_t{1} << 20)
+        : writer_(path, chunk * sizeof(T))
+        , chunk_(chunk)
+    {
+    }
+
+    std::size_t chunk() const {
+        return chunk_;
+    }
+
+    // buffer for the next chunk
+    std::span<T> next_buffer() {
+        std::span<std::byte> b = writer_.acquire();
+        return {reinterpret_cast<T*>(b.data()), chunk_};
+    }
+
+    // writes the first count elements of the buffer returned by next_buffer
+    void commit(std::size_t count) {
+        assert(count <= chunk_);
+        writer_.submit(count * sizeof(T));
+    }
+
+    // flushes and closes the file, reporting write errors; also done by the destructor
+    void close() {
+        writer_.close();
+    }
+
+private:
+    detail::async_writer writer_;
+    std::size_t chunk_;
+};
+
+template <typename T, typename E>
+void assign(file_sink<T>& sink, const E& e) {
+    const std::size_t n = extent(e);
+
+    decltype(auto) f = fold_constants(e);
+    decltype(auto) h = hoist_invariants(f);
+    detail::for_each_chunk(h, n, sink.chunk(), [&] (std::size_t begin, std::size_t end) {
+        std::span<T> buffer = sink.next_buffer();
+        for (std::size_t i = begin; i < end; ++i) {
+            buffer[i - begin] = evaluate_at(h, i);
+        }
+        sink.commit(end - begin);
+    });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
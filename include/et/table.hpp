@@ -0,0 +1,380 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "expr.hpp"
+#include "cost.hpp"
+#include "poly.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Tabulated functions of one and two variables. A table applied to
+// expressions gives an expression node, like the functions of math.hpp:
+//     et::table1d<double, et::log_axis<double>, et::interp::cubic> mu_T(axis, values);
+//     et::assign(nu, mu_T(et::expr(T)) / et::expr(rho));
+// The node refers to the table, which must outlive the expression.
+//
+// Axes map a coordinate to a fractional node index with one multiply-add
+// (uniform_axis) or a logarithm and a multiply-add (log_axis), so no search is
+// needed. Coordinates outside the axis are clamped to its ends. Index
+// computation, gathers and interpolation have no branches and vectorise with
+// the surrounding expression.
+//
+// Cubic interpolation is the Catmull-Rom spline: a cubic Hermite
+// interpolant with central difference slopes, linear extrapolation for the
+// neighbours of the end cells. interp::cubic computes it from the 4 (4x4)
+// neighbouring values, interp::cubic_precomputed stores the polynomial
+// coefficients of every cell, 4 (16) per cell, and evaluates them with
+// Horner's scheme.
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace interp {
+
+struct linear {};
+struct cubic {};
+struct cubic_precomputed {};
+
+} // namespace interp
+
+// n nodes first, first + dx, ..., last
+template <typename T>
+struct uniform_axis {
+    T first;
+    T inv_dx;
+    std::size_t n;
+
+    uniform_axis(T first, T last, std::size_t n)
+        : first(first)
+        , inv_dx(static_cast<T>(n - 1) / (last - first))
+        , n(n)
+    {
+        assert(n >= 2 && last > first);
+    }
+
+    // fractional index of x
+    T position(T x) const {
+        return (x - first) * inv_dx;
+    }
+
+    T node(std::size_t i) const {
+        return first + static_cast<T>(i) / inv_dx;
+    }
+};
+
+// n nodes spaced uniformly in log(x), first > 0
+template <typename T>
+struct log_axis {
+    T log_first;
+    T inv_dlog;
+    std::size_t n;
+
+    log_axis(T first, T last, std::size_t n)
+        : log_first(std::log(first))
+        , inv_dlog(static_cast<T>(n - 1) / (std::log(last) - std::log(first)))
+        , n(n)
+    {
+        assert(n >= 2 && last > first && first > 0);
+    }
+
+    T position(T x) const {
+        using std::log;
+        return (log(x) - log_first) * inv_dlog;
+    }
+
+    T node(std::size_t i) const {
+        using std::exp;
+        return exp(log_first + static_cast<T>(i) / inv_dlog);
+    }
+};
+
+namespace detail {
+
+// int indices, conversions to 32-bit integers vectorise on more targets
+template <typename T>
+struct table_cell {
+    int i;
+    T f;
+};
+
+// cell [i, i + 1] of n nodes containing the clamped position t, f in [0, 1]
+template <typename T>
+table_cell<T> locate(T t, std::size_t n) {
+    const T last = static_cast<T>(n - 1);
+    const T c = t > last ? last : t;
+    // NaN gives cell 0 and stays in the fraction
+    const T ci = c > T{0} ? c : T{0};
+    const int i = std::min(static_cast<int>(ci), static_cast<int>(n) - 2);
+    const T f = ci - static_cast<T>(i);
+    return {i, c == c ? f : c};
+}
+
+// Catmull-Rom basis: the cubic on [y0, y1] is sum_p f^p sum_a M[p][a] y[a]
+// for neighbours y = {y-1, y0, y1, y2}
+template <typename T>
+inline constexpr T catmull_rom[4][4] = {
+    {T(0), T(1), T(0), T(0)},
+    {T(-0.5), T(0), T(0.5), T(0)},
+    {T(1), T(-2.5), T(2), T(-0.5)},
+    {T(-0.5), T(1.5), T(-1.5), T(0.5)},
+};
+
+// weights of the neighbours at fraction f
+template <typename T>
+std::array<T, 4> cubic_weights(T f) {
+    std::array<T, 4> w;
+    for (std::size_t a = 0; a < 4; ++a) {
+        w[a] = horner(f, std::array<T, 4>{catmull_rom<T>[0][a], catmull_rom<T>[1][a],
+                                          catmull_rom<T>[2][a], catmull_rom<T>[3][a]});
+    }
+    return w;
+}
+
+// neighbours get(i - 1) ... get(i + 2) of cell i of n nodes, those outside
+// extrapolated linearly
+template <typename T, typename Get>
+std::array<T, 4> neighbours(Get get, int i, std::size_t n) {
+    const int last = static_cast<int>(n) - 1;
+    std::array<T, 4> y = {get(i > 0 ? i - 1 : 0), get(i), get(i + 1), get(i + 2 <= last ? i + 2 : last)};
+    y[0] = i > 0 ? y[0] : T{2} * y[1] - y[2];
+    y[3] = i + 2 <= last ? y[3] : T{2} * y[2] - y[1];
+    return y;
+}
+
+template <typename Interp, std::size_t dims>
+constexpr cost lookup_cost() {
+    if constexpr (std::is_same_v<Interp, interp::linear>) {
+        return dims == 1 ? cost{.add = 2, .mul = 1} : cost{.add = 6, .mul = 3};
+    }
+    else if constexpr (std::is_same_v<Interp, interp::cubic>) {
+        return dims == 1 ? cost{.add = 15, .mul = 16} : cost{.add = 39, .mul = 44};
+    }
+    else {
+        return dims == 1 ? cost{.add = 3, .mul = 3} : cost{.add = 15, .mul = 15};
+    }
+}
+
+template <typename Axis>
+inline constexpr cost axis_cost = {.add = 1, .mul = 1};
+
+template <typename T>
+inline constexpr cost axis_cost<log_axis<T>> = {.add = 1, .mul = 1, .transcendental = 1};
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace op {
+
+// node of a tabulated function, the table is referenced
+template <typename Table>
+struct lookup {
+    const Table* table;
+
+    template <typename... X>
+    auto operator()(const X&... x) const {
+        return table->value(x...);
+    }
+};
+
+} // namespace op
+
+template <typename Table>
+inline constexpr std::string_view symbol_v<op::lookup<Table>> = "table";
+
+template <typename Table>
+inline constexpr cost op_cost_v<op::lookup<Table>> = Table::lookup_cost;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// y(x) from values at the nodes of axis
+template <typename T, typename Axis = uniform_axis<T>, typename Interp = interp::linear>
+class table1d {
+public:
+    static constexpr cost lookup_cost = detail::axis_cost<Axis> + detail::lookup_cost<Interp, 1>();
+
+    table1d(const Axis& axis, std::span<const T> values)
+        : axis_(axis)
+        , y_(values.begin(), values.end())
+    {
+        assert(values.size() == axis.n && axis.n <= INT_MAX);
+        if constexpr (std::is_same_v<Interp, interp::cubic_precomputed>) {
+            c_.resize(4 * (axis_.n - 1));
+            for (std::size_t i = 0; i + 1 < axis_.n; ++i) {
+                const std::array<T, 4> y = detail::neighbours<T>(values_at(), static_cast<int>(i), axis_.n);
+                for (std::size_t p = 0; p < 4; ++p) {
+                    T s{};
+                    for (std::size_t a = 0; a < 4; ++a) {
+                        s += detail::catmull_rom<T>[p][a] * y[a];
+                    }
+                    c_[4 * i + p] = s;
+                }
+            }
+        }
+    }
+
+    T value(T x) const {
+        const auto [i, f] = detail::locate(axis_.position(x), axis_.n);
+        if constexpr (std::is_same_v<Interp, interp::linear>) {
+            return detail::mul_add(f, y_[i + 1] - y_[i], y_[i]);
+        }
+        else if constexpr (std::is_same_v<Interp, interp::cubic>) {
+            const std::array<T, 4> y = detail::neighbours<T>(values_at(), i, axis_.n);
+            const std::array<T, 4> w = detail::cubic_weights(f);
+            return w[0] * y[0] + w[1] * y[1] + w[2] * y[2] + w[3] * y[3];
+        }
+        else {
+            const T* c = c_.data() + 4 * i;
+            return horner(f, std::array<T, 4>{c[0], c[1], c[2], c[3]});
+        }
+    }
+
+    T operator()(T x) const {
+        return value(x);
+    }
+
+    template <Expr X>
+    auto operator()(X&& x) const {
+        return expr(op::lookup<table1d>{this}, unwrap(std::forward<X>(x)));
+    }
+
+    const Axis& axis() const {
+        return axis_;
+    }
+
+private:
+    auto values_at() const {
+        return [this] (int k) { return y_[k]; };
+    }
+
+    Axis axis_;
+    std::vector<T> y_;
+    // polynomial coefficients of the cells, cubic_precomputed only
+    std::vector<T> c_;
+};
+
+// z(x, y) from values at the nodes of the axes, row-major: the value at
+// nodes (i, j) is values[i * ny + j]
+template <typename T, typename AxisX = uniform_axis<T>, typename AxisY = AxisX, typename Interp = interp::linear>
+class table2d {
+public:
+    static constexpr cost lookup_cost = detail::axis_cost<AxisX> + detail::axis_cost<AxisY>
+        + detail::lookup_cost<Interp, 2>();
+
+    table2d(const AxisX& x, const AxisY& y, std::span<const T> values)
+        : x_(x)
+        , y_(y)
+        , z_(values.begin(), values.end())
+    {
+        assert(values.size() == x.n * y.n && x.n * y.n <= INT_MAX);
+        if constexpr (std::is_same_v<Interp, interp::cubic_precomputed>) {
+            c_.resize(16 * (x_.n - 1) * (y_.n - 1));
+            for (std::size_t i = 0; i + 1 < x_.n; ++i) {
+                for (std::size_t j = 0; j + 1 < y_.n; ++j) {
+                    const auto z = block(static_cast<int>(i), static_cast<int>(j));
+                    T* c = c_.data() + 16 * (i * (y_.n - 1) + j);
+                    for (std::size_t p = 0; p < 4; ++p) {
+                        for (std::size_t q = 0; q < 4; ++q) {
+                            T s{};
+                            for (std::size_t a = 0; a < 4; ++a) {
+                                for (std::size_t b = 0; b < 4; ++b) {
+                                    s += detail::catmull_rom<T>[p][a] * detail::catmull_rom<T>[q][b] * z[a][b];
+                                }
+                            }
+                            c[4 * p + q] = s;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    T value(T x, T y) const {
+        const auto [i, fx] = detail::locate(x_.position(x), x_.n);
+        const auto [j, fy] = detail::locate(y_.position(y), y_.n);
+        const std::size_t ny = y_.n;
+        if constexpr (std::is_same_v<Interp, interp::linear>) {
+            const T* z0 = z_.data() + i * ny + j;
+            const T* z1 = z0 + ny;
+            const T a = detail::mul_add(fy, z0[1] - z0[0], z0[0]);
+            const T b = detail::mul_add(fy, z1[1] - z1[0], z1[0]);
+            return detail::mul_add(fx, b - a, a);
+        }
+        else if constexpr (std::is_same_v<Interp, interp::cubic>) {
+            const auto z = block(i, j);
+            const std::array<T, 4> wx = detail::cubic_weights(fx);
+            const std::array<T, 4> wy = detail::cubic_weights(fy);
+            T s{};
+            for (std::size_t a = 0; a < 4; ++a) {
+                s += wx[a] * (wy[0] * z[a][0] + wy[1] * z[a][1] + wy[2] * z[a][2] + wy[3] * z[a][3]);
+            }
+            return s;
+        }
+        else {
+            const T* c = c_.data() + 16 * (i * (ny - 1) + j);
+            std::array<T, 4> r;
+            for (std::size_t p = 0; p < 4; ++p) {
+                r[p] = horner(fy, std::array<T, 4>{c[4 * p], c[4 * p + 1], c[4 * p + 2], c[4 * p + 3]});
+            }
+            return horner(fx, r);
+        }
+    }
+
+    T operator()(T x, T y) const {
+        return value(x, y);
+    }
+
+    template <class X, class Y>
+        requires Expr<X> || Expr<Y>
+    auto operator()(X&& x, Y&& y) const {
+        return expr(op::lookup<table2d>{this}, unwrap(std::forward<X>(x)), unwrap(std::forward<Y>(y)));
+    }
+
+    const AxisX& x_axis() const {
+        return x_;
+    }
+
+    const AxisY& y_axis() const {
+        return y_;
+    }
+
+private:
+    // 4x4 neighbours of cell (i, j), rows along x
+    std::array<std::array<T, 4>, 4> block(int i, int j) const {
+        const int ny = static_cast<int>(y_.n);
+        auto row = [&] (int r) {
+            return detail::neighbours<T>([&] (int k) { return z_[r * ny + k]; }, j, y_.n);
+        };
+        // rows outside are extrapolated like values, the neighbours are linear in them
+        const int last = static_cast<int>(x_.n) - 1;
+        std::array<std::array<T, 4>, 4> z = {row(i > 0 ? i - 1 : 0), row(i), row(i + 1), row(i + 2 <= last ? i + 2 : last)};
+        for (std::size_t b = 0; b < 4; ++b) {
+            z[0][b] = i > 0 ? z[0][b] : T{2} * z[1][b] - z[2][b];
+            z[3][b] = i + 2 <= last ? z[3][b] : T{2} * z[2][b] - z[1][b];
+        }
+        return z;
+    }
+
+    AxisX x_;
+    AxisY y_;
+    std::vector<T> z_;
+    // polynomial coefficients of the cells, cubic_precomputed only
+    std::vector<T> c_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
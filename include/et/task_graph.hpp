@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "array.hpp"
+#include "placeholders.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Work-stealing thread pool. Every worker has its own queue, jobs submitted
+// from a worker go to its queue, idle workers steal from the others.
+class thread_pool {
+public:
+    struct job {
+        void (*fn)(void* context, std::size_t index);
+        void* context;
+        std::size_t index;
+    };
+
+    explicit thread_pool(unsigned threads = std::thread::hardware_concurrency());
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    unsigned size() const;
+
+    // may be called from inside a job
+    void submit(job j);
+
+    // blocks until all submitted jobs, including the ones they submit, are done
+    void wait();
+
+    // blocks until remaining, counted down by the jobs of one caller, is
+    // zero. A worker calling it runs queued jobs meanwhile, so it may be
+    // called from inside a job.
+    void wait(const std::atomic<std::size_t>& remaining);
+
+private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+template <typename E>
+std::vector<memory_range> field_ranges(const E& e) {
+    std::vector<memory_range> ret;
+    auto visit = [&] <typename T> (const T& t) {
+        if constexpr (Field<T>) {
+            ret.push_back(range_of(t));
+        }
+    };
+    std::apply([&] (const auto&... t) { (visit(t), ...); }, tr::terminals{}(e));
+    return ret;
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+// A list of assignments with dependencies between them derived from the
+// fields they read and write. Running the graph gives the same result as
+// running the assignments in the order they were added.
+class task_graph {
+public:
+    // Destination and the fields referenced by the expression must outlive the graph
+    template <Field Dst, typename E>
+    std::size_t add(Dst& dst, const E& e) {
+        return add_task([&dst, e] { assign(dst, e); }, detail::range_of(dst), detail::field_ranges(e));
+    }
+
+    std::size_t size() const {
+        return tasks_.size();
+    }
+
+    // tasks that have to finish before the given one starts
+    const std::vector<std::size_t>& dependencies(std::size_t task) const {
+        return tasks_[task].predecessors;
+    }
+
+    // runs all tasks sequentially in order
+    void run();
+
+    // runs independent tasks concurrently, may be called from inside a job
+    // of pool
+    void run(thread_pool& pool);
+
+private:
+    struct task {
+        std::function<void()> body;
+        detail::memory_range write;
+        std::vector<detail::memory_range> reads;
+        std::vector<std::size_t> predecessors;
+        std::vector<std::size_t> successors;
+    };
+
+    struct run_state;
+
+    std::size_t add_task(std::function<void()> body, detail::memory_range write, std::vector<detail::memory_range> reads);
+
+    std::vector<task> tasks_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
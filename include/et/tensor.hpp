@@ -0,0 +1,429 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#pragma once
+
+#include "expr.hpp"
+#include "cost.hpp"
+#include "math.hpp"
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Small vectors and tensors as element types of fields, e.g. the viscous
+// stress from the velocity gradient in every cell:
+//     et::soa_tensor<double, 3, 3> grad_u(storage, n), tau(...);
+//     et::assign(tau, mu * (et::expr(grad_u) + et::transpose(et::expr(grad_u))));
+// vec and mat are aggregates whose operations are unrolled over the
+// components, the expression evaluates to straight-line code per cell.
+// soa_view stores every component in its own array (structure of arrays),
+// loads gather the components of a cell and stores scatter them.
+
+namespace et {
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T, std::size_t N>
+struct vec {
+    using value_type = T;
+    static constexpr std::size_t components = N;
+
+    T c[N];
+
+    constexpr T& operator[](std::size_t k) {
+        return c[k];
+    }
+
+    constexpr const T& operator[](std::size_t k) const {
+        return c[k];
+    }
+
+    friend constexpr bool operator==(const vec&, const vec&) = default;
+};
+
+// row-major
+template <typename T, std::size_t R, std::size_t C>
+struct mat {
+    using value_type = T;
+    static constexpr std::size_t rows = R;
+    static constexpr std::size_t cols = C;
+    static constexpr std::size_t components = R * C;
+
+    T c[R * C];
+
+    constexpr T& operator()(std::size_t r, std::size_t k) {
+        return c[r * C + k];
+    }
+
+    constexpr const T& operator()(std::size_t r, std::size_t k) const {
+        return c[r * C + k];
+    }
+
+    friend constexpr bool operator==(const mat&, const mat&) = default;
+};
+
+namespace detail {
+
+template <typename T>
+inline constexpr bool is_small_tensor = false;
+
+template <typename T, std::size_t N>
+inline constexpr bool is_small_tensor<vec<T, N>> = true;
+
+template <typename T, std::size_t R, std::size_t C>
+inline constexpr bool is_small_tensor<mat<T, R, C>> = true;
+
+// same shape, component type U
+template <typename V, typename U>
+struct rebind;
+
+template <typename T, std::size_t N, typename U>
+struct rebind<vec<T, N>, U> {
+    using type = vec<U, N>;
+};
+
+template <typename T, std::size_t R, std::size_t C, typename U>
+struct rebind<mat<T, R, C>, U> {
+    using type = mat<U, R, C>;
+};
+
+template <typename V, typename U>
+using rebind_t = typename rebind<V, U>::type;
+
+// tensor of the shape of V with components f(0), f(1), ...
+template <typename V, typename F>
+constexpr auto generate(F f) {
+    return [&] <std::size_t... k> (std::index_sequence<k...>) {
+        using U = std::remove_cvref_t<decltype(f(std::size_t{}))>;
+        return rebind_t<V, U>{{f(k)...}};
+    }(std::make_index_sequence<V::components>{});
+}
+
+// sum of f(0) ... f(n - 1), left to right
+template <std::size_t n, typename F>
+constexpr auto unrolled_sum(F f) {
+    return [&] <std::size_t... k> (std::index_sequence<k...>) {
+        return (... + f(k));
+    }(std::make_index_sequence<n>{});
+}
+
+} // namespace detail
+
+template <typename T>
+concept SmallTensor = detail::is_small_tensor<std::remove_cvref_t<T>>;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// component-wise arithmetic, scaling by scalars
+
+template <SmallTensor V>
+constexpr V operator+(const V& a, const V& b) {
+    return detail::generate<V>([&] (std::size_t k) { return a.c[k] + b.c[k]; });
+}
+
+template <SmallTensor V>
+constexpr V operator-(const V& a, const V& b) {
+    return detail::generate<V>([&] (std::size_t k) { return a.c[k] - b.c[k]; });
+}
+
+template <SmallTensor V>
+constexpr V operator-(const V& a) {
+    return detail::generate<V>([&] (std::size_t k) { return -a.c[k]; });
+}
+
+template <typename S, SmallTensor V>
+    requires std::is_arithmetic_v<S>
+constexpr auto operator*(S s, const V& a) {
+    return detail::generate<V>([&] (std::size_t k) { return s * a.c[k]; });
+}
+
+template <SmallTensor V, typename S>
+    requires std::is_arithmetic_v<S>
+constexpr auto operator*(const V& a, S s) {
+    return detail::generate<V>([&] (std::size_t k) { return a.c[k] * s; });
+}
+
+template <SmallTensor V, typename S>
+    requires std::is_arithmetic_v<S>
+constexpr auto operator/(const V& a, S s) {
+    return detail::generate<V>([&] (std::size_t k) { return a.c[k] / s; });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T, std::size_t N>
+constexpr T dot(const vec<T, N>& a, const vec<T, N>& b) {
+    return detail::unrolled_sum<N>([&] (std::size_t k) { return a[k] * b[k]; });
+}
+
+// matrix-vector product
+template <typename T, std::size_t R, std::size_t C>
+constexpr vec<T, R> dot(const mat<T, R, C>& a, const vec<T, C>& b) {
+    return detail::generate<vec<T, R>>([&] (std::size_t r) {
+        return detail::unrolled_sum<C>([&] (std::size_t k) { return a(r, k) * b[k]; });
+    });
+}
+
+// matrix product
+template <typename T, std::size_t R, std::size_t K, std::size_t C>
+constexpr mat<T, R, C> dot(const mat<T, R, K>& a, const mat<T, K, C>& b) {
+    return detail::generate<mat<T, R, C>>([&] (std::size_t rc) {
+        return detail::unrolled_sum<K>([&] (std::size_t k) { return a(rc / C, k) * b(k, rc % C); });
+    });
+}
+
+// double contraction a_ij b_ij
+template <typename T, std::size_t R, std::size_t C>
+constexpr T ddot(const mat<T, R, C>& a, const mat<T, R, C>& b) {
+    return detail::unrolled_sum<R * C>([&] (std::size_t k) { return a.c[k] * b.c[k]; });
+}
+
+template <typename T>
+constexpr vec<T, 3> cross(const vec<T, 3>& a, const vec<T, 3>& b) {
+    return {{a[1] * b[2] - a[2] * b[1],
+             a[2] * b[0] - a[0] * b[2],
+             a[0] * b[1] - a[1] * b[0]}};
+}
+
+template <typename T, std::size_t R, std::size_t C>
+constexpr mat<T, R, C> outer(const vec<T, R>& a, const vec<T, C>& b) {
+    return detail::generate<mat<T, R, C>>([&] (std::size_t rc) { return a[rc / C] * b[rc % C]; });
+}
+
+template <typename T, std::size_t N>
+constexpr T trace(const mat<T, N, N>& a) {
+    return detail::unrolled_sum<N>([&] (std::size_t k) { return a(k, k); });
+}
+
+template <typename T, std::size_t R, std::size_t C>
+constexpr mat<T, C, R> transpose(const mat<T, R, C>& a) {
+    return detail::generate<mat<T, C, R>>([&] (std::size_t rc) { return a(rc % R, rc / R); });
+}
+
+// Euclidean norm, Frobenius norm of matrices
+template <typename T, std::size_t N>
+T norm(const vec<T, N>& a) {
+    using std::sqrt;
+    return sqrt(dot(a, a));
+}
+
+template <typename T, std::size_t R, std::size_t C>
+T norm(const mat<T, R, C>& a) {
+    using std::sqrt;
+    return sqrt(ddot(a, a));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Expression nodes of the functions above
+
+#define ET_TENSOR_FUNC(fn) \
+namespace op { \
+struct fn { \
+    template <typename... Args> \
+    constexpr auto operator()(const Args&... args) const \
+    { \
+        return et::fn(args...); \
+    } \
+}; \
+} \
+template <> inline constexpr std::string_view symbol_v<op::fn> = #fn;
+
+ET_TENSOR_FUNC(dot);
+ET_TENSOR_FUNC(ddot);
+ET_TENSOR_FUNC(cross);
+ET_TENSOR_FUNC(outer);
+ET_TENSOR_FUNC(trace);
+ET_TENSOR_FUNC(transpose);
+ET_TENSOR_FUNC(norm);
+
+#undef ET_TENSOR_FUNC
+
+// costs by the shapes of the arguments, sums of n products take n - 1 additions
+
+template <typename T, typename U, std::size_t N>
+inline constexpr cost apply_cost_v<op::dot, vec<T, N>, vec<U, N>> = {.add = N - 1, .mul = N};
+
+template <typename T, typename U, std::size_t R, std::size_t C>
+inline constexpr cost apply_cost_v<op::dot, mat<T, R, C>, vec<U, C>> = {.add = R * (C - 1), .mul = R * C};
+
+template <typename T, typename U, std::size_t R, std::size_t K, std::size_t C>
+inline constexpr cost apply_cost_v<op::dot, mat<T, R, K>, mat<U, K, C>> = {.add = R * C * (K - 1), .mul = R * C * K};
+
+template <typename T, typename U, std::size_t R, std::size_t C>
+inline constexpr cost apply_cost_v<op::ddot, mat<T, R, C>, mat<U, R, C>> = {.add = R * C - 1, .mul = R * C};
+
+template <typename T, typename U>
+inline constexpr cost apply_cost_v<op::cross, vec<T, 3>, vec<U, 3>> = {.add = 3, .mul = 6};
+
+template <typename T, typename U, std::size_t R, std::size_t C>
+inline constexpr cost apply_cost_v<op::outer, vec<T, R>, vec<U, C>> = {.mul = R * C};
+
+template <typename T, std::size_t N>
+inline constexpr cost apply_cost_v<op::trace, mat<T, N, N>> = {.add = N - 1};
+
+template <typename T, std::size_t R, std::size_t C>
+inline constexpr cost apply_cost_v<op::transpose, mat<T, R, C>> = {};
+
+template <typename T, std::size_t N>
+inline constexpr cost apply_cost_v<op::norm, vec<T, N>> = {.add = N - 1, .mul = N, .sqrt = 1};
+
+template <typename T, std::size_t R, std::size_t C>
+inline constexpr cost apply_cost_v<op::norm, mat<T, R, C>> = {.add = R * C - 1, .mul = R * C, .sqrt = 1};
+
+template <Expr A>
+constexpr auto trace(A&& a) {
+    return expr(op::trace{}, unwrap(std::forward<A>(a)));
+}
+
+template <Expr A>
+constexpr auto transpose(A&& a) {
+    return expr(op::transpose{}, unwrap(std::forward<A>(a)));
+}
+
+template <Expr A>
+constexpr auto norm(A&& a) {
+    return expr(op::norm{}, unwrap(std::forward<A>(a)));
+}
+
+template <class A, class B>
+    requires Expr<A> || Expr<B>
+constexpr auto dot(A&& a, B&& b) {
+    return expr(op::dot{}, unwrap(std::forward<A>(a)), unwrap(std::forward<B>(b)));
+}
+
+template <class A, class B>
+    requires Expr<A> || Expr<B>
+constexpr auto ddot(A&& a, B&& b) {
+    return expr(op::ddot{}, unwrap(std::forward<A>(a)), unwrap(std::forward<B>(b)));
+}
+
+template <class A, class B>
+    requires Expr<A> || Expr<B>
+constexpr auto cross(A&& a, B&& b) {
+    return expr(op::cross{}, unwrap(std::forward<A>(a)), unwrap(std::forward<B>(b)));
+}
+
+template <class A, class B>
+    requires Expr<A> || Expr<B>
+constexpr auto outer(A&& a, B&& b) {
+    return expr(op::outer{}, unwrap(std::forward<A>(a)), unwrap(std::forward<B>(b)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Field of small tensors V whose components are stored in separate arrays of
+// S (const S for a read-only view). Elements are gathered by load and, for
+// writable views, scattered by assignment to operator[].
+template <typename S, SmallTensor V>
+class soa_view {
+public:
+    using value_type = V;
+
+    static constexpr std::size_t components = V::components;
+    static constexpr std::size_t storage_bytes = components * sizeof(S);
+
+    // element of a writable view
+    class reference {
+    public:
+        reference(const soa_view& view, std::size_t i) : view_(view), i_(i) {}
+
+        operator V() const {
+            return view_.load(i_);
+        }
+
+        reference& operator=(const V& value) {
+            [&] <std::size_t... k> (std::index_sequence<k...>) {
+                ((view_.c_[k][i_] = value.c[k]), ...);
+            }(std::make_index_sequence<components>{});
+            return *this;
+        }
+
+        reference& operator=(const reference& other) {
+            return *this = static_cast<V>(other);
+        }
+
+    private:
+        const soa_view& view_;
+        std::size_t i_;
+    };
+
+    soa_view() = default;
+
+    // one array per component, all of the same size
+    explicit soa_view(const std::array<std::span<S>, components>& c)
+        : n_(c[0].size())
+    {
+        for (std::size_t k = 0; k < components; ++k) {
+            assert(c[k].size() == n_);
+            c_[k] = c[k].data();
+        }
+    }
+
+    // components one after another: component k of element i is storage[k * n + i]
+    soa_view(std::span<S> storage, std::size_t n)
+        : n_(n)
+    {
+        assert(storage.size() >= components * n);
+        for (std::size_t k = 0; k < components; ++k) {
+            c_[k] = storage.data() + k * n;
+        }
+    }
+
+    // used by evaluation
+    V load(std::size_t i) const {
+        return [&] <std::size_t... k> (std::index_sequence<k...>) {
+            return V{{c_[k][i]...}};
+        }(std::make_index_sequence<components>{});
+    }
+
+    auto operator[](std::size_t i) const {
+        if constexpr (std::is_const_v<S>) {
+            return load(i);
+        }
+        else {
+            return reference(*this, i);
+        }
+    }
+
+    std::size_t size() const {
+        return n_;
+    }
+
+    std::span<S> component(std::size_t k) const {
+        return {c_[k], n_};
+    }
+
+    // smallest address range containing all components, for aliasing checks
+    std::pair<const S*, const S*> memory_bounds() const {
+        const S* begin = c_[0];
+        const S* end = c_[0] + n_;
+        for (std::size_t k = 1; k < components; ++k) {
+            begin = std::less<>{}(c_[k], begin) ? c_[k] : begin;
+            end = std::less<>{}(end, c_[k] + n_) ? c_[k] + n_ : end;
+        }
+        return {begin, end};
+    }
+
+private:
+    std::array<S*, components> c_{};
+    std::size_t n_ = 0;
+};
+
+template <typename T, std::size_t N>
+using soa_vector = soa_view<T, vec<std::remove_const_t<T>, N>>;
+
+template <typename T, std::size_t R, std::size_t C>
+using soa_tensor = soa_view<T, mat<std::remove_const_t<T>, R, C>>;
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace et
@@ -4,6 +4,7 @@
 #define TYPE_NAME_HPP
 
 #include <array>
+#include <cstdint>
 #include <string_view>
 // #if __cplusplus >= 202002L
 // #  include <source_location>
@@ -63,6 +64,25 @@ constexpr inline std::string_view get_type_name(T) {
     return {detail::type_name_array<T1>.data(), detail::type_name_array<T1>.size()};
 }
 
+namespace detail {
+
+// 64-bit FNV-1a
+constexpr inline std::uint64_t hash_string(std::string_view s, std::uint64_t h = 0xcbf29ce484222325ull) {
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+} // namespace detail
+
+// compact identifier of a type, stable between runs built with the same compiler
+template <typename T>
+constexpr inline std::uint64_t get_type_hash() {
+    return detail::hash_string(get_type_name<T>());
+}
+
 } // namespace et
 
 #endif // TYPE_NAME_HPP
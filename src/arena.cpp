@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#include "et/arena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define ET_ARENA_MMAP 1
+#endif
+
+namespace {
+
+constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+
+// alignment of blocks, a page: buffers are aligned relative to the start of their block
+constexpr std::size_t block_alignment = 4096;
+
+std::byte* reserve(std::size_t size, bool huge_pages) {
+#ifdef ET_ARENA_MMAP
+    // pages are not touched here, first touch by the owning thread decides their NUMA node
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    if (huge_pages) {
+        madvise(p, size, MADV_HUGEPAGE);
+    }
+#endif
+    return static_cast<std::byte*>(p);
+#else
+    (void)huge_pages;
+    return static_cast<std::byte*>(::operator new(size, std::align_val_t{block_alignment}));
+#endif
+}
+
+void release(std::byte* data, std::size_t size) {
+#ifdef ET_ARENA_MMAP
+    munmap(data, size);
+#else
+    (void)size;
+    ::operator delete(data, std::align_val_t{block_alignment});
+#endif
+}
+
+struct thread_arenas {
+    std::mutex mutex;
+    std::vector<et::arena*> arenas;
+    et::arena_options options;
+};
+
+thread_arenas& registry() {
+    static thread_arenas r;
+    return r;
+}
+
+struct registered_arena {
+    et::arena arena;
+
+    explicit registered_arena(const et::arena_options& options) : arena(options) {
+        std::lock_guard lock(registry().mutex);
+        registry().arenas.push_back(&arena);
+    }
+
+    ~registered_arena() {
+        std::lock_guard lock(registry().mutex);
+        std::erase(registry().arenas, &arena);
+    }
+};
+
+et::arena_options current_options() {
+    std::lock_guard lock(registry().mutex);
+    return registry().options;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::ostream& et::operator<<(std::ostream& s, const arena_stats& stats)
+{
+    return s << "used " << stats.used << " B, reserved " << stats.reserved
+             << " B, high water " << stats.high_water << " B";
+}
+
+et::arena::arena(arena_options options)
+    : options_(options)
+{
+    if (options_.huge_pages) {
+        options_.block_size = (options_.block_size + huge_page_size - 1) / huge_page_size * huge_page_size;
+    }
+}
+
+et::arena::~arena()
+{
+    for (const block& b : blocks_) {
+        release(b.data, b.size);
+    }
+}
+
+void* et::arena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    for (;;) {
+        if (current_ < blocks_.size()) {
+            const block& b = blocks_[current_];
+            std::size_t begin = (offset_ + alignment - 1) & ~(alignment - 1);
+            if (begin + bytes <= b.size) {
+                offset_ = begin + bytes;
+                high_water_ = std::max(high_water_, base_ + offset_);
+                return b.data + begin;
+            }
+            if (current_ + 1 < blocks_.size()) {
+                base_ += b.size;
+                ++current_;
+                offset_ = 0;
+                continue;
+            }
+        }
+        // blocks are aligned to at least a page, so the first buffer in a block needs no padding
+        std::size_t size = std::max(options_.block_size, bytes);
+        const std::size_t granularity = options_.huge_pages ? huge_page_size : block_alignment;
+        size = (size + granularity - 1) / granularity * granularity;
+        blocks_.push_back({reserve(size, options_.huge_pages), size});
+        if (blocks_.size() > 1) {
+            base_ += blocks_[current_].size;
+            current_ = blocks_.size() - 1;
+        }
+        offset_ = 0;
+    }
+}
+
+void et::arena::reset()
+{
+    rewind(0, 0);
+}
+
+void et::arena::rewind(std::size_t block, std::size_t offset)
+{
+    base_ = 0;
+    for (std::size_t i = 0; i < block && i < blocks_.size(); ++i) {
+        base_ += blocks_[i].size;
+    }
+    current_ = block;
+    offset_ = offset;
+}
+
+et::arena_stats et::arena::stats() const
+{
+    arena_stats s;
+    for (const block& b : blocks_) {
+        s.reserved += b.size;
+    }
+    s.used = current_ < blocks_.size() ? base_ + offset_ : 0;
+    s.high_water = high_water_;
+    return s;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void et::set_thread_arena_options(const arena_options& options)
+{
+    std::lock_guard lock(registry().mutex);
+    registry().options = options;
+}
+
+et::arena& et::thread_arena()
+{
+    thread_local registered_arena a(current_options());
+    return a.arena;
+}
+
+et::arena_stats et::thread_arena_stats()
+{
+    std::lock_guard lock(registry().mutex);
+    arena_stats total;
+    for (const arena* a : registry().arenas) {
+        arena_stats s = a->stats();
+        total.used += s.used;
+        total.reserved += s.reserved;
+        total.high_water += s.high_water;
+    }
+    return total;
+}
+
+void et::reset_thread_arenas()
+{
+    std::lock_guard lock(registry().mutex);
+    for (arena* a : registry().arenas) {
+        a->reset();
+    }
+}
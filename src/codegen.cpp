@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#include "et/codegen.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::string env(const char* name) {
+    const char* v = std::getenv(name);
+    return v ? v : "";
+}
+
+// the temporary directory is writable by everyone: use a subdirectory only
+// the user can write to, so that nobody else can plant objects to be loaded
+std::filesystem::path private_temp_dir() {
+    const uid_t uid = getuid();
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / ("et-" + std::to_string(uid));
+    if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        throw std::runtime_error("et::codegen: can not create " + dir.string());
+    }
+    struct stat st;
+    if (lstat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != uid || (st.st_mode & 077) != 0) {
+        throw std::runtime_error("et::codegen: " + dir.string() + " is not a private directory");
+    }
+    return dir;
+}
+
+std::filesystem::path default_cache_dir() {
+    if (std::string dir = env("ET_CACHE_DIR"); !dir.empty()) {
+        return dir;
+    }
+    if (std::string dir = env("XDG_CACHE_HOME"); !dir.empty()) {
+        return std::filesystem::path(dir) / "et";
+    }
+    if (std::string home = env("HOME"); !home.empty()) {
+        return std::filesystem::path(home) / ".cache" / "et";
+    }
+    return private_temp_dir();
+}
+
+et::codegen::options resolve(et::codegen::options opt) {
+    if (opt.compiler.empty()) {
+        opt.compiler = env("CXX");
+    }
+    if (opt.compiler.empty()) {
+        opt.compiler = "c++";
+    }
+    if (opt.cache_dir.empty()) {
+        opt.cache_dir = default_cache_dir();
+    }
+    if (opt.include_dir.empty()) {
+        opt.include_dir = env("ET_INCLUDE_DIR");
+    }
+    if (opt.include_dir.empty()) {
+        // set with -DET_CODEGEN_INCLUDE_DIR for installed or relocated builds
+        opt.include_dir = ET_INCLUDE_DIR;
+    }
+    return opt;
+}
+
+std::string quote(const std::string& s) {
+    std::string r = "'";
+    for (char c : s) {
+        if (c == '\'') {
+            r += "'\\''";
+        }
+        else {
+            r += c;
+        }
+    }
+    return r + "'";
+}
+
+std::string read_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+// file of this process next to path, renamed to path when complete
+std::filesystem::path process_file(const std::filesystem::path& path) {
+    std::filesystem::path tmp = path;
+    tmp += '.';
+    tmp += std::to_string(getpid());
+    tmp += ".tmp";
+    return tmp;
+}
+
+// written to a file of this process and renamed, like the object
+void write_file(const std::filesystem::path& path, const std::string& text) {
+    const std::filesystem::path tmp = process_file(path);
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out << text;
+        if (!out.flush()) {
+            std::error_code ec;
+            std::filesystem::remove(tmp, ec);
+            throw std::runtime_error("et::codegen: can not write " + path.string());
+        }
+    }
+    std::filesystem::rename(tmp, path);
+}
+
+// hash of the et headers, which the generated source includes
+std::uint64_t headers_hash(const std::filesystem::path& include_dir) {
+    std::vector<std::filesystem::path> headers;
+    std::error_code ec;
+    for (std::filesystem::recursive_directory_iterator it(include_dir / "et", ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file()) {
+            headers.push_back(it->path());
+        }
+    }
+    std::sort(headers.begin(), headers.end());
+    std::uint64_t h = et::detail::hash_string(include_dir.string());
+    for (const auto& header : headers) {
+        h = et::detail::hash_string(header.filename().string(), h);
+        h = et::detail::hash_string(read_file(header), h);
+    }
+    return h;
+}
+
+std::string hex(std::uint64_t h) {
+    char buf[17];
+    std::snprintf(buf, sizeof buf, "%016llx", static_cast<unsigned long long>(h));
+    return buf;
+}
+
+void build(const et::codegen::options& opt, const std::filesystem::path& cpp, const std::filesystem::path& so) {
+    // compile to a file of this process and rename, so that concurrent
+    // processes never load a partially written object
+    const std::filesystem::path tmp = process_file(so);
+    std::filesystem::path log = so;
+    log.replace_extension(".log");
+
+    std::string command = opt.compiler + " " + opt.flags + " -fPIC -shared"
+        + " -I" + quote(opt.include_dir.string())
+        + " -o " + quote(tmp.string()) + " " + quote(cpp.string())
+        + " > " + quote(log.string()) + " 2>&1";
+    if (std::system(command.c_str()) != 0) {
+        std::error_code ec;
+        std::filesystem::remove(tmp, ec);
+        throw std::runtime_error("et::codegen: " + command + " failed:\n" + read_file(log));
+    }
+    std::filesystem::rename(tmp, so);
+}
+
+et::codegen::entry_point open_object(const std::filesystem::path& so) {
+    // never closed, the entry points stay valid for the lifetime of the process
+    void* handle = dlopen(so.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        throw std::runtime_error(std::string("et::codegen: ") + dlerror());
+    }
+    void* f = dlsym(handle, "et_kernel");
+    if (!f) {
+        throw std::runtime_error(std::string("et::codegen: ") + dlerror());
+    }
+    return reinterpret_cast<et::codegen::entry_point>(f);
+}
+
+} // namespace
+
+et::codegen::entry_point et::codegen::load(const source& src, const options& options)
+{
+    const codegen::options opt = resolve(options);
+
+    static std::mutex mutex;
+    static std::map<std::string, entry_point> loaded;
+    static std::map<std::filesystem::path, std::uint64_t> headers;
+    std::lock_guard lock(mutex);
+
+    // the object depends on the toolchain and the headers as well as on the
+    // source; the headers are hashed once per process
+    auto [header, inserted] = headers.try_emplace(opt.include_dir);
+    if (inserted) {
+        header->second = headers_hash(opt.include_dir);
+    }
+    const std::uint64_t key = et::detail::hash_string(opt.flags, et::detail::hash_string(opt.compiler, src.hash ^ header->second));
+
+    std::filesystem::create_directories(opt.cache_dir);
+    const std::filesystem::path base = opt.cache_dir / hex(key);
+    std::filesystem::path cpp = base;
+    cpp += ".cpp";
+    std::filesystem::path so = base;
+    so += ".so";
+
+    if (auto it = loaded.find(so.string()); it != loaded.end()) {
+        return it->second;
+    }
+    // the source is kept next to the object, a different one means a hash
+    // collision or an interrupted compilation
+    if (!std::filesystem::exists(so) || read_file(cpp) != src.text) {
+        write_file(cpp, src.text);
+        build(opt, cpp, so);
+    }
+    entry_point f = open_object(so);
+    loaded.emplace(so.string(), f);
+    return f;
+}
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#include "et/cost.hpp"
+
+std::ostream& et::operator<<(std::ostream& s, const cost& c)
+{
+    return s << c.flops() << " flop"
+             << " (add " << c.add
+             << ", mul " << c.mul
+             << ", div " << c.div
+             << ", sqrt " << c.sqrt
+             << ", transcendental " << c.transcendental
+             << ", other " << c.other << "), "
+             << c.bytes_loaded << " B loaded, "
+             << c.bytes_stored << " B stored, "
+             << c.intensity() << " flop/B";
+}
+
+std::ostream& et::operator<<(std::ostream& s, const eval_stats& st)
+{
+    return s << st.calls << " calls, "
+             << st.elements << " elements, "
+             << st.seconds << " s, "
+             << st.gflops() << " GFLOP/s, "
+             << st.bandwidth() << " GB/s, "
+             << st.intensity() << " flop/B";
+}
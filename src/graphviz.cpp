@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#include "et/graphviz.hpp"
+
+namespace {
+
+std::ostream& write_escaped(std::ostream& s, std::string_view str) {
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            s << '\\';
+        }
+        s << c;
+    }
+    return s;
+}
+
+} // namespace
+
+void et::detail::write_dot_dag_begin(std::ostream& s)
+{
+    s << "digraph \"\" {\n";
+    s << "    node [fontname=\"monospace\"];\n";
+}
+
+void et::detail::write_dot_dag_node(std::ostream& s, int id, const graph_node& n)
+{
+    s << "    n" << id << " [label=\"";
+    write_escaped(s, n.label);
+    if (!n.terminal) {
+        s << "\\n" << n.node_cost.flops() << " / " << n.tree_cost.flops() << " flop";
+    }
+    if (n.seconds > 0.0) {
+        s << "\\n" << n.seconds << " s";
+    }
+    s << '"';
+    if (n.terminal) {
+        s << ",shape=box";
+    }
+    s << "];\n";
+
+    for (int child : n.children) {
+        s << "    n" << id << " -> n" << child << " ;\n";
+    }
+}
+
+// shared nodes are known only at the end, their attributes are added then
+void et::detail::write_dot_dag_end(std::ostream& s, const std::vector<int>& counts)
+{
+    for (std::size_t id = 0; id < counts.size(); ++id) {
+        if (counts[id] > 1) {
+            s << "    n" << id << " [xlabel=\"x" << counts[id] << "\",style=bold];\n";
+        }
+    }
+    s << "}\n";
+}
+
+void et::detail::write_json_dag_begin(std::ostream& s)
+{
+    s << "{\n  \"nodes\": [";
+}
+
+void et::detail::write_json_dag_node(std::ostream& s, int id, const graph_node& n)
+{
+    s << (id ? ",\n" : "\n");
+    s << "    {\"id\": " << id << ", \"label\": \"";
+    write_escaped(s, n.label);
+    s << "\", \"type\": \"";
+    write_escaped(s, n.type_name);
+    s << "\", \"terminal\": " << (n.terminal ? "true" : "false")
+      << ", \"flops\": " << n.node_cost.flops()
+      << ", \"tree_flops\": " << n.tree_cost.flops()
+      << ", \"tree_bytes\": " << n.tree_cost.bytes()
+      << ", \"seconds\": " << n.seconds
+      << ", \"children\": [";
+    for (std::size_t i = 0; i < n.children.size(); ++i) {
+        s << (i ? ", " : "") << n.children[i];
+    }
+    s << "]}";
+}
+
+// counts[id] is the number of times node id is evaluated in the tree
+void et::detail::write_json_dag_end(std::ostream& s, int root, const std::vector<int>& counts)
+{
+    s << "\n  ],\n  \"root\": " << root << ",\n  \"counts\": [";
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+        s << (i ? ", " : "") << counts[i];
+    }
+    s << "]\n}\n";
+}
+
+std::ostream& et::write_dot_dag(std::ostream& s, const expr_graph& g)
+{
+    std::vector<int> counts;
+    detail::write_dot_dag_begin(s);
+    for (std::size_t id = 0; id < g.nodes.size(); ++id) {
+        detail::write_dot_dag_node(s, static_cast<int>(id), g.nodes[id]);
+        counts.push_back(g.nodes[id].count);
+    }
+    detail::write_dot_dag_end(s, counts);
+    return s;
+}
+
+std::ostream& et::write_json_dag(std::ostream& s, const expr_graph& g)
+{
+    std::vector<int> counts;
+    detail::write_json_dag_begin(s);
+    for (std::size_t id = 0; id < g.nodes.size(); ++id) {
+        detail::write_json_dag_node(s, static_cast<int>(id), g.nodes[id]);
+        counts.push_back(g.nodes[id].count);
+    }
+    detail::write_json_dag_end(s, g.root, counts);
+    return s;
+}
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#include "et/profile.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <ios>
+#include <mutex>
+
+namespace {
+
+using et::profile::entry;
+
+std::vector<entry> sorted(std::vector<entry> entries) {
+    std::stable_sort(entries.begin(), entries.end(), [] (const entry& a, const entry& b) {
+        return a.stats.seconds > b.stats.seconds;
+    });
+    return entries;
+}
+
+std::ostream& write_hash(std::ostream& s, std::uint64_t hash) {
+    auto flags = s.flags();
+    s << std::hex << hash;
+    s.flags(flags);
+    return s;
+}
+
+std::ostream& write_json_string(std::ostream& s, std::string_view str) {
+    s << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            s << '\\';
+        }
+        s << c;
+    }
+    return s << '"';
+}
+
+std::ostream& write_csv_string(std::ostream& s, std::string_view str) {
+    s << '"';
+    for (char c : str) {
+        if (c == '"') {
+            s << '"';
+        }
+        s << c;
+    }
+    return s << '"';
+}
+
+std::ostream& write_json(std::ostream& s, const std::vector<entry>& entries) {
+    s << "[\n";
+    bool first = true;
+    for (const entry& e : entries) {
+        if (!first) {
+            s << ",\n";
+        }
+        first = false;
+        s << "  {\"kind\": \"" << e.kind << "\", \"hash\": \"";
+        write_hash(s, e.hash) << "\", \"name\": ";
+        write_json_string(s, e.name);
+        s << ", \"calls\": " << e.stats.calls
+          << ", \"elements\": " << e.stats.elements
+          << ", \"seconds\": " << e.stats.seconds
+          << ", \"flops\": " << e.stats.flops
+          << ", \"bytes\": " << e.stats.bytes
+          << ", \"gflops\": " << e.stats.gflops()
+          << ", \"bandwidth_gbs\": " << e.stats.bandwidth()
+          << ", \"intensity\": " << e.stats.intensity()
+          << "}";
+    }
+    return s << "\n]\n";
+}
+
+std::ostream& write_csv(std::ostream& s, const std::vector<entry>& entries) {
+    s << "kind,hash,name,calls,elements,seconds,flops,bytes,gflops,bandwidth_gbs,intensity\n";
+    for (const entry& e : entries) {
+        s << e.kind << ',';
+        write_hash(s, e.hash) << ',';
+        write_csv_string(s, e.name);
+        s << ',' << e.stats.calls
+          << ',' << e.stats.elements
+          << ',' << e.stats.seconds
+          << ',' << e.stats.flops
+          << ',' << e.stats.bytes
+          << ',' << e.stats.gflops()
+          << ',' << e.stats.bandwidth()
+          << ',' << e.stats.intensity()
+          << '\n';
+    }
+    return s;
+}
+
+struct registry {
+    std::mutex mutex;
+    // deque keeps references to entries valid
+    std::deque<entry> entries;
+    std::string report_path;
+
+    ~registry() {
+        if (report_path.empty()) {
+            return;
+        }
+        std::ofstream os(report_path);
+        auto all = sorted({entries.begin(), entries.end()});
+        if (report_path.ends_with(".csv")) {
+            write_csv(os, all);
+        }
+        else {
+            write_json(os, all);
+        }
+    }
+};
+
+registry& instance() {
+    static registry r;
+    return r;
+}
+
+} // namespace
+
+void et::profile::entry::add(const cost& c, std::size_t n, double seconds)
+{
+    std::lock_guard lock(instance().mutex);
+    stats.add(c, n, seconds);
+}
+
+et::profile::entry& et::profile::register_kernel(std::string_view kind, std::string_view name, std::uint64_t hash)
+{
+    registry& r = instance();
+    std::lock_guard lock(r.mutex);
+    auto it = std::find_if(r.entries.begin(), r.entries.end(), [&] (const entry& e) {
+        return e.hash == hash && e.kind == kind && e.name == name;
+    });
+    if (it != r.entries.end()) {
+        return *it;
+    }
+    return r.entries.emplace_back(entry{kind, name, hash, {}});
+}
+
+std::vector<et::profile::entry> et::profile::snapshot()
+{
+    registry& r = instance();
+    std::vector<entry> ret;
+    {
+        std::lock_guard lock(r.mutex);
+        ret.assign(r.entries.begin(), r.entries.end());
+    }
+    return sorted(std::move(ret));
+}
+
+void et::profile::reset()
+{
+    registry& r = instance();
+    std::lock_guard lock(r.mutex);
+    for (entry& e : r.entries) {
+        e.stats = {};
+    }
+}
+
+std::ostream& et::profile::write_json(std::ostream& s)
+{
+    return ::write_json(s, snapshot());
+}
+
+std::ostream& et::profile::write_csv(std::ostream& s)
+{
+    return ::write_csv(s, snapshot());
+}
+
+void et::profile::report_at_exit(std::string path)
+{
+    registry& r = instance();
+    std::lock_guard lock(r.mutex);
+    r.report_path = std::move(path);
+}
@@ -0,0 +1,285 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#include "et/stream.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+[[noreturn]] void fail(const char* what, const std::filesystem::path& path, int err = errno) {
+    throw std::system_error(err, std::generic_category(), std::string(what) + " " + path.string());
+}
+
+std::byte* map(int fd, std::size_t size, bool writable, const std::filesystem::path& path) {
+    if (size == 0) {
+        return nullptr;
+    }
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* p = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        fail("mmap", path);
+    }
+    madvise(p, size, MADV_SEQUENTIAL);
+    return static_cast<std::byte*>(p);
+}
+
+struct page_range {
+    std::byte* begin;
+    std::size_t length;
+};
+
+// pages touched by [begin, end); with inner only the ones not shared with
+// the bytes around it
+page_range pages(std::byte* data, std::size_t size, std::size_t begin, std::size_t end, bool inner) {
+    static const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    auto down = [] (std::size_t x) { return x / page * page; };
+    auto up = [] (std::size_t x) { return (x + page - 1) / page * page; };
+    // the mapping starts at a page boundary, the part of the last page past the end is not shared
+    end = std::min(end, size);
+    std::size_t b = inner ? up(begin) : down(begin);
+    std::size_t e = inner && end < size ? down(end) : up(end);
+    if (b >= e) {
+        return {data, 0};
+    }
+    return {data + b, e - b};
+}
+
+} // namespace
+
+et::detail::mapped_file::mapped_file(const std::filesystem::path& path, access mode)
+{
+    const bool writable = mode == access::read_write;
+    int fd = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        fail("open", path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        fail("stat", path, err);
+    }
+    try {
+        data_ = map(fd, static_cast<std::size_t>(st.st_size), writable, path);
+    }
+    catch (...) {
+        close(fd);
+        throw;
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    // the mapping keeps the file open
+    close(fd);
+}
+
+et::detail::mapped_file::mapped_file(const std::filesystem::path& path, std::size_t size)
+{
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fail("open", path);
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        int err = errno;
+        close(fd);
+        fail("truncate", path, err);
+    }
+    try {
+        data_ = map(fd, size, true, path);
+    }
+    catch (...) {
+        close(fd);
+        throw;
+    }
+    size_ = size;
+    close(fd);
+}
+
+et::detail::mapped_file::~mapped_file()
+{
+    if (data_) {
+        munmap(data_, size_);
+    }
+}
+
+et::detail::mapped_file::mapped_file(mapped_file&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0))
+{
+}
+
+et::detail::mapped_file& et::detail::mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if (this != &other) {
+        if (data_) {
+            munmap(data_, size_);
+        }
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+void et::detail::mapped_file::will_need(std::size_t begin, std::size_t end) const
+{
+    if (!data_) {
+        return;
+    }
+    page_range r = pages(data_, size_, begin, end, false);
+    if (r.length > 0) {
+        madvise(r.begin, r.length, MADV_WILLNEED);
+    }
+}
+
+void et::detail::mapped_file::dont_need(std::size_t begin, std::size_t end) const
+{
+    if (!data_) {
+        return;
+    }
+    // pages shared with the neighbouring chunks are kept
+    page_range r = pages(data_, size_, begin, end, true);
+    if (r.length > 0) {
+        madvise(r.begin, r.length, MADV_DONTNEED);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct et::detail::async_writer::impl {
+    std::filesystem::path path;
+    int fd = -1;
+    std::unique_ptr<std::byte[]> buffers[2];
+    std::size_t buffer_bytes;
+    std::size_t sizes[2] = {0, 0};
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool pending[2] = {false, false}; // protected by mutex
+    bool stop = false;
+    int error = 0;
+    int filling = 0; // used by the caller only
+    std::thread thread;
+
+    impl(const std::filesystem::path& p, std::size_t bytes)
+        : path(p)
+        , buffer_bytes(bytes)
+    {
+        fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            fail("open", path);
+        }
+        buffers[0] = std::make_unique<std::byte[]>(bytes);
+        buffers[1] = std::make_unique<std::byte[]>(bytes);
+        thread = std::thread([this] { run(); });
+    }
+
+    int write_all(const std::byte* data, std::size_t size) {
+        while (size > 0) {
+            ssize_t r = ::write(fd, data, size);
+            if (r < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno;
+            }
+            data += r;
+            size -= static_cast<std::size_t>(r);
+        }
+        return 0;
+    }
+
+    void run() {
+        int writing = 0;
+        for (;;) {
+            std::size_t size;
+            bool failed;
+            {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [&] { return pending[writing] || stop; });
+                if (!pending[writing]) {
+                    return;
+                }
+                size = sizes[writing];
+                failed = error != 0;
+            }
+            // after a failure buffers are still released so that the caller does not block
+            int err = failed ? 0 : write_all(buffers[writing].get(), size);
+            {
+                std::lock_guard lock(mutex);
+                if (err != 0) {
+                    error = err;
+                }
+                pending[writing] = false;
+            }
+            changed.notify_all();
+            writing ^= 1;
+        }
+    }
+
+    void finish() {
+        if (!thread.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        changed.notify_all();
+        thread.join();
+        if (::close(fd) != 0 && error == 0) {
+            error = errno;
+        }
+        fd = -1;
+    }
+};
+
+et::detail::async_writer::async_writer(const std::filesystem::path& path, std::size_t buffer_bytes)
+    : impl_(std::make_unique<impl>(path, buffer_bytes))
+{
+}
+
+et::detail::async_writer::~async_writer()
+{
+    impl_->finish();
+}
+
+std::span<std::byte> et::detail::async_writer::acquire()
+{
+    impl& d = *impl_;
+    assert(d.thread.joinable());
+    std::unique_lock lock(d.mutex);
+    d.changed.wait(lock, [&] { return !d.pending[d.filling]; });
+    return {d.buffers[d.filling].get(), d.buffer_bytes};
+}
+
+void et::detail::async_writer::submit(std::size_t bytes)
+{
+    impl& d = *impl_;
+    assert(bytes <= d.buffer_bytes);
+    {
+        std::lock_guard lock(d.mutex);
+        d.sizes[d.filling] = bytes;
+        d.pending[d.filling] = true;
+    }
+    d.changed.notify_all();
+    d.filling ^= 1;
+}
+
+void et::detail::async_writer::close()
+{
+    impl_->finish();
+    if (impl_->error != 0) {
+        fail("write", impl_->path, std::exchange(impl_->error, 0));
+    }
+}
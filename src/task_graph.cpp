@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#include "et/task_graph.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct worker_queue {
+    std::mutex mutex;
+    std::deque<et::thread_pool::job> jobs;
+};
+
+// pool and worker index of the current thread, if it is a worker
+thread_local const void* current_pool = nullptr;
+thread_local std::size_t current_worker = 0;
+
+} // namespace
+
+struct et::thread_pool::impl {
+    std::vector<worker_queue> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable job_done;
+    std::atomic<std::size_t> queued = 0;
+    std::size_t pending = 0; // protected by mutex
+    bool stop = false;
+    std::atomic<std::size_t> next_queue = 0;
+
+    explicit impl(unsigned n) : queues(n == 0 ? 1 : n) {
+        for (std::size_t i = 0; i < queues.size(); ++i) {
+            threads.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    ~impl() {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        work_available.notify_all();
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    bool try_pop(std::size_t self, job& j) {
+        // own queue from the back, others from the front
+        {
+            worker_queue& q = queues[self];
+            std::lock_guard lock(q.mutex);
+            if (!q.jobs.empty()) {
+                j = q.jobs.back();
+                q.jobs.pop_back();
+                return true;
+            }
+        }
+        for (std::size_t k = 1; k < queues.size(); ++k) {
+            worker_queue& q = queues[(self + k) % queues.size()];
+            std::lock_guard lock(q.mutex);
+            if (!q.jobs.empty()) {
+                j = q.jobs.front();
+                q.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void execute(const job& j) {
+        queued.fetch_sub(1);
+        j.fn(j.context, j.index);
+        std::lock_guard lock(mutex);
+        --pending;
+        job_done.notify_all();
+    }
+
+    void run(std::size_t self) {
+        current_pool = this;
+        current_worker = self;
+        for (;;) {
+            job j;
+            if (try_pop(self, j)) {
+                execute(j);
+                continue;
+            }
+            std::unique_lock lock(mutex);
+            work_available.wait(lock, [&] { return stop || queued.load() > 0; });
+            if (stop) {
+                return;
+            }
+        }
+    }
+
+    void submit(job j) {
+        {
+            // queued is changed under the mutex so that a worker can not miss
+            // the wakeup, and before the push so that the worker popping the
+            // job can not decrement it first
+            std::lock_guard lock(mutex);
+            ++pending;
+            queued.fetch_add(1);
+        }
+        std::size_t q = current_pool == this ? current_worker : next_queue.fetch_add(1) % queues.size();
+        {
+            std::lock_guard lock(queues[q].mutex);
+            queues[q].jobs.push_back(j);
+        }
+        work_available.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock lock(mutex);
+        job_done.wait(lock, [&] { return pending == 0; });
+    }
+
+    void wait(const std::atomic<std::size_t>& remaining) {
+        if (current_pool == this) {
+            // a blocked worker could hold the jobs waited for in its queue
+            job j;
+            while (remaining.load() > 0) {
+                if (try_pop(current_worker, j)) {
+                    execute(j);
+                    continue;
+                }
+                // the remaining jobs are running on other workers
+                std::unique_lock lock(mutex);
+                job_done.wait(lock, [&] { return remaining.load() == 0 || queued.load() > 0; });
+            }
+            return;
+        }
+        std::unique_lock lock(mutex);
+        job_done.wait(lock, [&] { return remaining.load() == 0; });
+    }
+};
+
+et::thread_pool::thread_pool(unsigned threads)
+    : impl_(std::make_unique<impl>(threads))
+{
+}
+
+et::thread_pool::~thread_pool() = default;
+
+unsigned et::thread_pool::size() const
+{
+    return static_cast<unsigned>(impl_->queues.size());
+}
+
+void et::thread_pool::submit(job j)
+{
+    impl_->submit(j);
+}
+
+void et::thread_pool::wait()
+{
+    impl_->wait();
+}
+
+void et::thread_pool::wait(const std::atomic<std::size_t>& remaining)
+{
+    impl_->wait(remaining);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t et::task_graph::add_task(std::function<void()> body, detail::memory_range write, std::vector<detail::memory_range> reads)
+{
+    std::size_t id = tasks_.size();
+    task t{std::move(body), write, std::move(reads), {}, {}};
+
+    for (std::size_t i = 0; i < id; ++i) {
+        task& prev = tasks_[i];
+        bool conflict = overlap(prev.write, t.write);
+        for (const auto& r : t.reads) {
+            conflict = conflict || overlap(prev.write, r);
+        }
+        for (const auto& r : prev.reads) {
+            conflict = conflict || overlap(r, t.write);
+        }
+        if (conflict) {
+            t.predecessors.push_back(i);
+            prev.successors.push_back(id);
+        }
+    }
+
+    tasks_.push_back(std::move(t));
+    return id;
+}
+
+void et::task_graph::run()
+{
+    for (auto& t : tasks_) {
+        t.body();
+    }
+}
+
+struct et::task_graph::run_state {
+    task_graph& graph;
+    thread_pool& pool;
+    std::unique_ptr<std::atomic<std::size_t>[]> remaining;
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    std::atomic<bool> failed = false;
+
+    // submitted jobs of this run that have not finished, the pool may run
+    // other work and the run itself may be a job of the pool
+    std::atomic<std::size_t> in_flight = 0;
+
+    void submit(std::size_t index) {
+        in_flight.fetch_add(1);
+        pool.submit({&run_state::execute, this, index});
+    }
+
+    static void execute(void* context, std::size_t index) {
+        auto& self = *static_cast<run_state*>(context);
+        task& t = self.graph.tasks_[index];
+        try {
+            t.body();
+        }
+        catch (...) {
+            std::lock_guard lock(self.error_mutex);
+            if (!self.error) {
+                self.error = std::current_exception();
+            }
+            self.failed.store(true);
+        }
+        // after a failure no more tasks are started, the running ones finish
+        if (!self.failed.load()) {
+            for (std::size_t s : t.successors) {
+                if (self.remaining[s].fetch_sub(1) == 1) {
+                    self.submit(s);
+                }
+            }
+        }
+        // the successors are counted already, the last access to self
+        self.in_flight.fetch_sub(1);
+    }
+};
+
+void et::task_graph::run(thread_pool& pool)
+{
+    run_state r{*this, pool, std::make_unique<std::atomic<std::size_t>[]>(tasks_.size()), {}, {}, false, 0};
+    for (std::size_t i = 0; i < tasks_.size(); ++i) {
+        r.remaining[i].store(tasks_[i].predecessors.size());
+    }
+    for (std::size_t i = 0; i < tasks_.size(); ++i) {
+        if (tasks_[i].predecessors.empty()) {
+            r.submit(i);
+        }
+    }
+    pool.wait(r.in_flight);
+
+    if (r.error) {
+        std::rethrow_exception(r.error);
+    }
+}
@@ -0,0 +1,962 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Ilya Popov
+
+#include "et/array.hpp"
+#include "et/codegen.hpp"
+#include "et/half.hpp"
+#include "et/health.hpp"
+#include "et/kernel.hpp"
+#include "et/math.hpp"
+#include "et/newton.hpp"
+#include "et/nontemporal.hpp"
+#include "et/poly.hpp"
+#include "et/precision.hpp"
+#include "et/print.hpp"
+#include "et/stream.hpp"
+#include "et/table.hpp"
+#include "et/task_graph.hpp"
+#include "et/tensor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+bool verify(bool x) {
+    if (!x) {
+        std::cerr << "Fatal error\n";
+        std::exit(1);
+    }
+    return x;
+}
+
+static int counted_calls = 0;
+
+struct counted {
+    template <typename T>
+    T operator()(T x) const {
+        ++counted_calls;
+        return x;
+    }
+};
+
+void test_assign() {
+    std::vector<double> rho = {1.0, 2.0, 4.0, 8.0};
+    std::vector<double> out(rho.size());
+    double dt = 0.5;
+    double dx = 0.25;
+
+    et::assign(out, dt / (et::expr(rho) * dx));
+    for (std::size_t i = 0; i < rho.size(); ++i) {
+        verify(out[i] == dt / (rho[i] * dx));
+    }
+
+    et::assign(std::span(out), et::expr(rho) + 1.0);
+    verify(out[3] == 9.0);
+
+    verify(et::sum(et::expr(rho) * 2.0) == 30.0);
+}
+
+void test_hoist() {
+    std::vector<double> rho = {1.0, 2.0, 4.0, 8.0};
+    std::vector<double> out(rho.size());
+    double dt = 0.5;
+    double dx = 0.25;
+
+    // dt / dx does not depend on the index and is replaced by its value
+    auto e = et::expr(rho) * (et::expr(dt) / dx);
+    auto h = et::hoist_invariants(e);
+    static_assert(std::is_same_v<decltype(h), et::expr<et::op::multiplies, const std::vector<double>&, double>>);
+    std::cout << e << " -> " << et::get_type_name(h) << '\n';
+
+    static_assert(et::detail::is_invariant<decltype(sqrt(et::expr(dt) / dx))>);
+    static_assert(!et::detail::is_invariant<decltype(sqrt(et::expr(rho) / dx))>);
+
+    counted_calls = 0;
+    et::assign(out, et::expr(rho) + et::make_expr(counted{}, et::expr(dt) * dx));
+    verify(counted_calls == 1);
+    verify(out[2] == 4.125);
+}
+
+void test_assign_all() {
+    const double gamma = 1.4;
+    const double R = 287.0;
+    std::vector<double> rho = {1.0, 1.2, 0.8};
+    std::vector<double> rhoU = {0.0, 12.0, -4.0};
+    std::vector<double> E = {2.5e5, 3.0e5, 2.0e5};
+    std::vector<double> p(rho.size()), T(rho.size()), c(rho.size());
+
+    auto e_p = (gamma - 1.0) * (et::expr(E) - 0.5 * et::expr(rhoU) * rhoU / rho);
+    auto e_T = e_p / (et::expr(rho) * R);
+    auto e_c = sqrt(gamma * e_p / rho);
+
+    et::assign_all(std::tie(p, T, c), std::tuple(e_p, e_T, e_c));
+
+    std::vector<double> p1(rho.size()), T1(rho.size()), c1(rho.size());
+    et::assign(p1, e_p);
+    et::assign(T1, e_T);
+    et::assign(c1, e_c);
+    verify(p == p1 && T == T1 && c == c1);
+}
+
+void test_cost() {
+    std::vector<double> rho = {1.0, 2.0, 4.0, 8.0};
+    std::vector<float> out(rho.size());
+    double dt = 0.5;
+    double dx = 0.25;
+
+    using E = decltype(dt / (et::expr(rho) * dx) + exp(et::expr(rho)) + ipow<5>(et::expr(rho)));
+    constexpr et::cost c = et::cost_v<E>;
+    static_assert(c.add == 2 && c.mul == 4 && c.div == 1 && c.transcendental == 1);
+    static_assert(c.flops() == 8 && c.bytes_loaded == 3 * sizeof(double) && c.bytes_stored == 0);
+    static_assert(et::assign_cost_v<std::vector<float>, E>.bytes_stored == sizeof(float));
+    std::cout << c << '\n';
+
+    et::eval_stats stats;
+    et::assign(out, et::expr(rho) * (et::expr(dt) / dx), stats);
+    et::assign(out, et::expr(rho) * (et::expr(dt) / dx), stats);
+    // dt / dx is hoisted out of the loop and not counted
+    verify(stats.per_element == et::cost{.mul = 1, .bytes_loaded = sizeof(double), .bytes_stored = sizeof(float)});
+    verify(stats.calls == 2 && stats.elements == 2 * rho.size());
+    verify(out[1] == 4.0f);
+
+    et::eval_stats sum_stats;
+    verify(et::reduce(et::expr(rho) * 2.0, 0.0, et::op::plus{}, sum_stats) == 30.0);
+    verify(sum_stats.per_element.flops() == 2);
+    std::cout << sum_stats << '\n';
+
+    // totals over kernels of different cost
+    et::assign(out, exp(et::expr(rho)) + et::expr(rho), stats);
+    verify(stats.flops == static_cast<double>(2 * rho.size() * 1 + rho.size() * 2));
+    verify(stats.bytes == static_cast<double>(2 * rho.size() * (sizeof(double) + sizeof(float)) + rho.size() * (2 * sizeof(double) + sizeof(float))));
+}
+
+void test_profile() {
+    std::vector<double> rho = {1.0, 2.0, 4.0, 8.0};
+    std::vector<double> out(rho.size());
+
+    et::profile::reset();
+    for (int i = 0; i < 3; ++i) {
+        et::assign(out, et::expr(rho) * rho);
+    }
+    verify(et::sum(et::expr(rho) * rho) == 85.0);
+
+    auto entries = et::profile::snapshot();
+    if constexpr (et::profile::enabled) {
+        auto assign = std::find_if(entries.begin(), entries.end(), [] (const auto& e) { return e.kind == "assign"; });
+        verify(assign != entries.end());
+        verify(assign->stats.calls == 3 && assign->stats.elements == 3 * rho.size());
+        verify(assign->stats.per_element.mul == 1);
+        verify(assign->hash == et::get_type_hash<decltype(et::expr(rho) * rho)>());
+    }
+    else {
+        verify(entries.empty());
+    }
+
+    // the other evaluation paths are recorded as well
+    et::profile::reset();
+    et::assign(out, et::expr(rho) * 2.0, et::check_finite{});
+    et::assign(out, et::expr(rho) + 1.0, et::streaming{});
+    verify(et::sum(et::expr(rho) - 1.0, 0.0, et::pairwise_summation{}) == 11.0);
+    verify(et::sum(et::expr(rho) / 2.0, 0.0, et::reproducible_summation{}) == 7.5);
+    auto recorded = [] <typename E> (std::string_view kind, const E&) {
+        auto all = et::profile::snapshot();
+        return std::any_of(all.begin(), all.end(), [&] (const auto& e) {
+            return e.kind == kind && e.hash == et::get_type_hash<E>() && e.stats.calls == 1 && e.stats.flops > 0.0;
+        });
+    };
+    verify(recorded("assign", et::expr(rho) * 2.0) == et::profile::enabled);
+    verify(recorded("assign", et::expr(rho) + 1.0) == et::profile::enabled);
+    verify(recorded("reduce", et::expr(rho) - 1.0) == et::profile::enabled);
+    verify(recorded("reduce", et::expr(rho) / 2.0) == et::profile::enabled);
+    et::profile::write_json(std::cout);
+    et::profile::write_csv(std::cout);
+}
+
+void test_task_graph() {
+    const std::size_t n = 1000;
+    std::vector<double> a(n, 1.0), b(n), c(n), d(n);
+
+    et::task_graph g;
+    g.add(b, et::expr(a) * 2.0);
+    g.add(c, et::expr(a) + 1.0);
+    g.add(d, et::expr(b) + c);
+    g.add(a, et::expr(d) * 0.5);
+    std::span<double> c_tail(c.data() + n / 2, n / 2);
+    g.add(c_tail, et::expr(c_tail) * 3.0);
+
+    verify(g.dependencies(0).empty());
+    verify(g.dependencies(1).empty());
+    verify((g.dependencies(2) == std::vector<std::size_t>{0, 1}));
+    verify((g.dependencies(3) == std::vector<std::size_t>{0, 1, 2}));
+    verify((g.dependencies(4) == std::vector<std::size_t>{1, 2}));
+
+    et::thread_pool pool(4);
+    for (int step = 0; step < 100; ++step) {
+        g.run(pool);
+    }
+    std::vector<double> a_par = a, c_par = c;
+
+    std::fill(a.begin(), a.end(), 1.0);
+    for (int step = 0; step < 100; ++step) {
+        g.run();
+    }
+    verify(a == a_par && c == c_par);
+
+    // tasks depending on a failed one are not started
+    struct throw_negative {
+        double operator()(double x) const {
+            if (x < 0.0) {
+                throw std::runtime_error("negative");
+            }
+            return x;
+        }
+    };
+    std::vector<double> p(n, -1.0), q(n), r(n, 0.0);
+    et::task_graph h;
+    h.add(q, et::expr(throw_negative{}, p));
+    h.add(r, et::expr(q) + 1.0);
+    bool failed = false;
+    try {
+        h.run(pool);
+    }
+    catch (const std::runtime_error&) {
+        failed = true;
+    }
+    verify(failed && r == std::vector<double>(n, 0.0));
+
+    // graphs run from jobs of the same pool wait only for their own tasks
+    for (unsigned threads : {1u, 2u}) {
+        et::thread_pool outer(threads);
+        struct nested {
+            et::thread_pool* pool;
+            std::vector<double> x[3];
+            std::vector<double> y[3];
+        } ctx{&outer, {}, {}};
+        for (std::size_t k = 0; k < 3; ++k) {
+            ctx.x[k].assign(n, static_cast<double>(k));
+            ctx.y[k].assign(n, 0.0);
+            outer.submit({[] (void* c, std::size_t j) {
+                auto& x = *static_cast<nested*>(c);
+                et::task_graph inner;
+                inner.add(x.y[j], et::expr(x.x[j]) + 1.0);
+                inner.add(x.y[j], et::expr(x.y[j]) * 2.0);
+                inner.run(*x.pool);
+            }, &ctx, k});
+        }
+        outer.wait();
+        for (std::size_t k = 0; k < 3; ++k) {
+            verify(ctx.y[k] == std::vector<double>(n, 2.0 * static_cast<double>(k + 1)));
+        }
+    }
+}
+
+void test_aliasing() {
+    const std::size_t n = 16;
+    std::vector<double> u(n + 2);
+    for (std::size_t i = 0; i < u.size(); ++i) {
+        u[i] = static_cast<double>(i * i);
+    }
+    // interior cells, u[0] and u[n + 1] are ghost cells
+    std::span<double> v(u.data() + 1, n);
+
+    std::vector<float> f(n);
+    static_assert(!et::detail::may_alias<std::vector<float>, decltype(et::expr(v) * 2.0)>);
+    static_assert(et::detail::may_alias<std::span<double>, decltype(et::expr(f) + et::shift(v, 1))>);
+
+    using et::detail::assign_strategy;
+    verify(et::detail::plan_assign(v, et::expr(v) * 2.0).strategy == assign_strategy::forward);
+    verify(et::detail::plan_assign(v, et::shift(v, 1) - v).strategy == assign_strategy::forward);
+    verify(et::detail::plan_assign(v, et::shift(v, -1) - v).strategy == assign_strategy::backward);
+    auto laplace = et::shift(v, -1) - 2.0 * et::expr(v) + et::shift(v, 1);
+    auto plan = et::detail::plan_assign(v, laplace);
+    verify(plan.strategy == assign_strategy::line_buffer && plan.delay == 1);
+    verify(et::detail::plan_assign(std::span(u.data(), n), et::expr(std::span(u.data() + 2, n)) - v).strategy == assign_strategy::forward);
+
+    auto reference = [&] (auto&& e) {
+        std::vector<double> r(n);
+        et::assign(r, e);
+        return r;
+    };
+    auto check = [&] (auto&& e) {
+        std::vector<double> saved = u;
+        std::vector<double> r = reference(e);
+        et::assign(v, e);
+        verify(std::equal(v.begin(), v.end(), r.begin()));
+        u = saved;
+    };
+    check(et::expr(v) * 2.0);
+    check(et::shift(v, 1) - v);
+    check(et::shift(v, -1) - v);
+    check(laplace);
+    check(et::shift(v, -1) * et::shift(v, 1) + et::shift(v, 1) * 0.5);
+
+    // reading far behind needs a full temporary
+    std::vector<double> big(40000);
+    for (std::size_t i = 0; i < big.size(); ++i) {
+        big[i] = static_cast<double>(i);
+    }
+    std::span<double> head(big.data(), 20000);
+    std::span<double> tail(big.data() + 20000, 20000);
+    std::span<double> mid(big.data() + 10000, 20000);
+    verify(et::detail::plan_assign(mid, et::expr(head) + tail).strategy == assign_strategy::temporary);
+    et::assign(mid, et::expr(head) + tail);
+    verify(mid[0] == 20000.0 && mid[19999] == 2.0 * 19999.0 + 20000.0);
+
+    // several outputs, each expression may read every destination
+    std::vector<double> a(n, 0.0);
+    std::vector<double> b_ref(u.begin() + 1, u.end() - 1);
+    std::vector<double> a_ref(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        a_ref[i] = u[i] + 1.0;
+        b_ref[i] = 2.0 * u[i + 1] + u[i];
+    }
+    et::assign_all(std::tie(a, v), std::tuple(et::shift(v, -1) + 1.0, 2.0 * et::expr(v) + et::shift(v, -1)));
+    verify(a == a_ref && std::equal(v.begin(), v.end(), b_ref.begin()));
+
+    // fields without element references, overlapping at different offsets
+    std::vector<std::uint16_t> bits(n + 1);
+    for (std::size_t i = 0; i < bits.size(); ++i) {
+        bits[i] = et::binary16::from_float(static_cast<float>(i));
+    }
+    auto lo = et::as_binary16(std::span(bits.data(), n));
+    auto hi = et::as_binary16(std::span(bits.data() + 1, n));
+    et::assign(hi, et::expr(lo) * 2.0f);
+    for (std::size_t i = 0; i < n; ++i) {
+        verify(hi.load(i) == 2.0f * static_cast<float>(i));
+    }
+    std::vector<double> cx(n + 1), cy(n + 1), cz(n + 1);
+    for (std::size_t i = 0; i <= n; ++i) {
+        cx[i] = static_cast<double>(i);
+        cy[i] = -static_cast<double>(i);
+        cz[i] = 1.0;
+    }
+    et::soa_vector<double, 3> w0({std::span(cx).first(n), std::span(cy).first(n), std::span(cz).first(n)});
+    et::soa_vector<double, 3> w1({std::span(cx).subspan(1, n), std::span(cy).subspan(1, n), std::span(cz).subspan(1, n)});
+    static_assert(et::detail::may_alias<decltype(w1), decltype(et::expr(w0))>);
+    et::assign(w1, 3.0 * et::expr(w0));
+    for (std::size_t i = 0; i < n; ++i) {
+        verify(cx[i + 1] == 3.0 * static_cast<double>(i) && cz[i + 1] == 3.0);
+    }
+
+    // a broadcast reference to an element of dst is read by every element
+    std::vector<double> s = {2.0, 4.0, 6.0};
+    static_assert(et::detail::may_alias<std::vector<double>, decltype(et::expr(s) / et::expr(s[0]))>);
+    static_assert(!et::detail::may_alias<std::vector<double>, decltype(et::expr(f) / 2.0)>);
+    verify(et::detail::plan_assign(s, et::expr(s) / et::expr(s[0])).strategy == assign_strategy::temporary);
+    et::assign(s, et::expr(s) / et::expr(s[0]));
+    verify((s == std::vector<double>{1.0, 2.0, 3.0}));
+}
+
+void test_arena() {
+    et::arena a({.block_size = 4096});
+    void* p1 = a.allocate(100);
+    verify(reinterpret_cast<std::uintptr_t>(p1) % et::arena::default_alignment == 0);
+    {
+        et::arena::scope scope(a);
+        a.allocate(3000);
+        a.allocate(3000); // does not fit, goes to a new block
+        verify(a.stats().reserved == 2 * 4096);
+    }
+    verify(a.stats().used == 100);
+    verify(a.stats().high_water == 4096 + 3000);
+    a.reset();
+    verify(a.allocate(8) == p1);
+
+    std::vector<double> rho = {1.0, 2.0, 4.0, 8.0};
+    auto rho2 = et::eval_to_temp(et::expr(rho) * rho);
+    std::vector<double> out(rho.size());
+    et::assign(out, et::expr(rho2) + rho2);
+    verify(out[3] == 128.0);
+    std::cout << et::thread_arena_stats() << '\n';
+    verify(et::thread_arena_stats().used >= rho.size() * sizeof(double));
+    et::reset_thread_arenas();
+    verify(et::thread_arena_stats().used == 0);
+}
+
+void test_streaming() {
+    const std::size_t n = 100000;
+    auto path = std::filesystem::temp_directory_path() / "et_array_test_field.bin";
+    {
+        et::mapped_field<double> rho(path, n);
+        std::vector<double> index(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            index[i] = static_cast<double>(i);
+        }
+        et::assign(rho, et::expr(index) * 0.5, et::streaming{.chunk = 4096});
+    }
+
+    et::mapped_field<const double> rho(path);
+    verify(rho.size() == n);
+    verify(rho[3] == 1.5);
+    double total = et::reduce(et::expr(rho) * 2.0, 0.0, et::op::plus{}, et::streaming{.chunk = 1000});
+    verify(total == et::sum(et::expr(rho) * 2.0));
+    verify(total == static_cast<double>(n) * (n - 1) / 2);
+
+    std::vector<double> out(n);
+    et::assign(out, et::expr(rho) + rho, et::streaming{.chunk = 777});
+    verify(out[n - 1] == static_cast<double>(n - 1));
+
+    // derived field written by the background thread, two assignments are appended
+    auto out_path = std::filesystem::temp_directory_path() / "et_array_test_sink.bin";
+    {
+        et::file_sink<float> sink(out_path, 1000);
+        et::assign(sink, sqrt(et::expr(rho)));
+        et::assign(sink, et::expr(rho) * 0.0);
+        sink.close();
+    }
+    et::mapped_field<const float> written(out_path);
+    verify(written.size() == 2 * n);
+    verify(written[8] == 2.0f && written[n - 1] == static_cast<float>(std::sqrt((n - 1) * 0.5)));
+    verify(written[n] == 0.0f && written[2 * n - 1] == 0.0f);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(out_path);
+}
+
+void test_precision() {
+    // stored in float, computed in double
+    std::vector<float> a = {1e8f, 3.0f}, b = {1.0f, 0.5f}, c = {-1e8f, 0.25f};
+    std::vector<float> out(a.size());
+    et::assign(out, et::expr(a) + b + c);
+    verify(out[0] == 0.0f);
+    auto e = et::compute_in<double>(et::expr(a) + b + c);
+    static_assert(std::is_same_v<et::element_type_t<decltype(e)>, double>);
+    et::assign(out, e);
+    verify(out[0] == 1.0f && out[1] == 3.75f);
+
+    // terminals held by value are copied out of the temporary expression
+    auto e2 = et::compute_in<double>(et::expr(std::span<const float>(a)) + b + c);
+    et::assign(out, e2);
+    verify(out[0] == 1.0f && out[1] == 3.75f);
+
+    // a bare terminal expression is converted as well
+    auto e3 = et::compute_in<double>(et::expr(a));
+    static_assert(std::is_same_v<et::element_type_t<decltype(e3)>, double>);
+    verify(et::evaluate_at(e3, 1) == 3.0);
+    static_assert(std::is_same_v<et::element_type_t<decltype(et::compute_in<double>(et::expr(1.5f)))>, double>);
+
+    // integer and bool terminals are not converted
+    std::vector<int> idx = {3, 4};
+    auto odd = et::compute_in<double>(et::expr(idx) % 2 == 1);
+    static_assert(std::is_same_v<et::element_type_t<decltype(odd)>, bool>);
+    std::vector<double> sel(a.size());
+    et::assign(sel, et::select(odd, et::expr(a), et::expr(b)));
+    verify(sel[0] == 1e8 && sel[1] == 0.5);
+
+    // compensated chain of additions
+    std::vector<double> x = {1e16, 2.0}, y = {1.0, 3.0}, z = {-1e16, 4.0};
+    std::vector<double> r(x.size());
+    et::assign(r, et::expr(x) + y + z);
+    verify(r[0] == 0.0);
+    auto scaled = 2.0 * (et::expr(x) + y + z);
+    auto ce = et::compensate_sums(scaled);
+    std::cout << et::get_type_name(ce) << '\n';
+    et::assign(r, et::compensate_sums(et::expr(x) + y + z));
+    verify(r[0] == 1.0 && r[1] == 9.0);
+    et::assign(r, ce);
+    verify(r[0] == 2.0);
+
+    // compensated and pairwise reductions
+    std::vector<float> tenth(1000000, 0.1f);
+    const double exact = 1000000 * static_cast<double>(0.1f);
+    float naive = et::sum(et::expr(tenth));
+    float kahan = et::sum(et::expr(tenth), 0.0f, et::kahan_summation{});
+    float pairwise = et::sum(et::expr(tenth), 0.0f, et::pairwise_summation{});
+    std::cout << "naive " << naive << " kahan " << kahan << " pairwise " << pairwise << '\n';
+    verify(kahan == static_cast<float>(exact));
+    verify(std::abs(pairwise - exact) < std::abs(naive - exact));
+    verify(et::sum(et::compensate_sums(et::expr(x) + y + z), 0.0, et::kahan_summation{}) == 10.0);
+
+    // reproducible reductions: the same bits for any number of threads
+    std::vector<double> v(100003);
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        v[i] = (static_cast<double>(i % 7) - 3.1) * std::pow(10.0, static_cast<double>(i % 13) - 6.0);
+    }
+    auto sq = et::expr(v) * et::expr(v) - 0.5 * et::expr(v);
+    const double reference = et::sum(sq, 1.0, et::reproducible_summation{});
+    verify(std::abs(reference - et::sum(sq, 1.0, et::kahan_summation{})) <= 1e-12 * std::abs(reference));
+    for (unsigned threads : {1u, 2u, 3u, 8u}) {
+        et::thread_pool pool(threads);
+        verify(et::sum(sq, 1.0, et::reproducible_summation{}, pool) == reference);
+    }
+    et::thread_pool pool(3);
+    for (std::size_t block : {1u, 16u, 100u, 1024u, 200000u}) {
+        const double s = et::sum(sq, 0.0, et::reproducible_summation{block});
+        verify(et::sum(sq, 0.0, et::reproducible_summation{block}, pool) == s);
+    }
+    verify(et::sum(et::expr(std::vector<double>{}), 2.0, et::reproducible_summation{}, pool) == 2.0);
+
+    // called from jobs of the same pool, every worker busy
+    for (unsigned threads : {1u, 2u}) {
+        et::thread_pool outer(threads);
+        struct nested {
+            et::thread_pool* pool;
+            const decltype(sq)* e;
+            double result[4];
+        } ctx{&outer, &sq, {}};
+        for (std::size_t j = 0; j < 4; ++j) {
+            outer.submit({[] (void* c, std::size_t k) {
+                auto& x = *static_cast<nested*>(c);
+                x.result[k] = et::sum(*x.e, 1.0, et::reproducible_summation{}, *x.pool);
+            }, &ctx, j});
+        }
+        outer.wait();
+        verify(std::all_of(std::begin(ctx.result), std::end(ctx.result), [&] (double r) { return r == reference; }));
+    }
+}
+
+void test_half() {
+    static_assert(et::detail::binary16_to_float(0x3c00) == 1.0f);
+    static_assert(et::detail::float_to_binary16(65504.0f) == 0x7bff);
+    static_assert(et::detail::float_to_binary16(65520.0f) == 0x7c00);
+    static_assert(et::detail::float_to_binary16(1.0f + 1.0f / 4096) == 0x3c00);
+    static_assert(et::bfloat16::from_float(1.0f + 1.0f / 256) == 0x3f80);
+
+    for (std::uint32_t h = 0; h < 0x7c00; ++h) {
+        auto bits = static_cast<std::uint16_t>(h);
+        verify(et::binary16::from_float(et::binary16::to_float(bits)) == bits);
+        verify(et::detail::binary16_to_float(bits) == et::binary16::to_float(bits));
+    }
+
+    std::vector<std::uint16_t> wall_distance(5), length_scale(5);
+    std::vector<double> x = {0.0, 0.5, 1.5, -2.0, 1e-3};
+    et::assign(et::as_binary16(wall_distance), et::expr(x) * 2.0);
+    et::assign(et::as_bfloat16(length_scale), et::expr(x) + 1.0);
+    verify(wall_distance[2] == 0x4200 && length_scale[1] == 0x3fc0);
+
+    const auto& wd = wall_distance;
+    auto d = et::as_binary16<double>(wd);
+    auto l = et::as_bfloat16(length_scale);
+    static_assert(std::is_same_v<et::element_type_t<decltype(et::expr(d) * l)>, double>);
+    static_assert(et::cost_v<decltype(d)>.bytes_loaded == 2);
+    std::vector<double> out(x.size());
+    et::assign(out, et::expr(d) * l);
+    verify(out[3] == -4.0 * -1.0);
+    verify(std::abs(out[4] - 2e-3 * 1.001) < 1e-5);
+
+    // doubles are rounded once: just above the tie between 1 and its
+    // successor, the nearest float would be the tie itself
+    constexpr double above_tie = 1.0 + 0x1p-11 + 0x1p-40;
+    static_assert(et::detail::float_to_binary16(et::detail::to_float_round_odd(above_tie)) == 0x3c01);
+    static_assert(et::detail::float_to_binary16(et::detail::to_float_round_odd(-above_tie)) == 0xbc01);
+    static_assert(et::detail::float_to_binary16(static_cast<float>(above_tie)) == 0x3c00);
+    std::vector<std::uint16_t> one(1);
+    et::as_binary16<double>(one)[0] = above_tie;
+    verify(one[0] == 0x3c01);
+}
+
+void test_nontemporal() {
+    std::vector<double> a(1003), b(1003);
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        a[i] = static_cast<double>(i);
+    }
+    std::vector<double> ref(a.size() - 1), out(a.size());
+    et::assign(ref, et::expr(std::span(a).subspan(1)) * 2.0 + 1.0);
+
+    // unaligned start and odd length
+    std::span<double> dst = std::span(out).subspan(1);
+    auto e = et::expr(std::span(a).subspan(1)) * 2.0 + 1.0;
+    et::assign(dst, e, et::nontemporal_stores{.min_bytes = 0});
+    verify(std::equal(ref.begin(), ref.end(), dst.begin()));
+
+    std::vector<float> f(37);
+    et::assign(f, et::expr(std::span(a).first(37)) * 0.5, et::nontemporal_stores{.min_bytes = 0});
+    verify(f[36] == 18.0f);
+
+    verify(!et::detail::use_nontemporal(b, et::expr(a) * 2.0, et::nontemporal_stores{}));
+#if defined(__SSE2__)
+    verify(et::detail::use_nontemporal(b, et::expr(a) * 2.0, et::nontemporal_stores{.min_bytes = 0}));
+    // in-place update reading behind needs the aliasing-aware loop
+    verify(!et::detail::use_nontemporal(dst, et::shift(dst, -1) + 1.0, et::nontemporal_stores{.min_bytes = 0}));
+#endif
+    et::assign(b, et::expr(a) - 1.0, et::nontemporal_stores{});
+    verify(b[1002] == 1001.0);
+}
+
+void test_health() {
+    std::vector<double> p = {1.0, 4.0, 0.0, -1.0, 9.0};
+    std::vector<double> c(p.size());
+
+    et::reset_thread_nonfinite();
+    auto report = et::assign(c, sqrt(et::expr(p)), et::check_finite{});
+    verify(!report.ok() && report.first_nonfinite == 3);
+    verify(c[4] == 3.0);
+    verify(et::thread_nonfinite_seen());
+
+    et::reset_thread_nonfinite();
+    verify(et::assign(c, et::expr(p) * 2.0, et::check_finite{}).ok());
+    verify(!et::thread_nonfinite_seen());
+
+    // overflow when narrowing to the destination type
+    std::vector<float> f(p.size());
+    report = et::assign(f, et::expr(p) * 1e38, et::check_finite{});
+    verify(report.first_nonfinite == 1);
+
+    // overflow inside the store of a packed destination
+    std::vector<std::uint16_t> bits(p.size());
+    report = et::assign(et::as_binary16(bits), et::expr(p) * 1e5, et::check_finite{});
+    verify(report.first_nonfinite == 0);
+
+    // in-place update with a shift is checked in a second pass
+    std::vector<double> u = {1.0, 2.0, 0.0, 4.0, 5.0};
+    std::span<double> v(u.data() + 1, 4);
+    report = et::assign(v, 1.0 / et::shift(v, -1), et::check_finite{});
+    verify(report.first_nonfinite == 2 && u[2] == 0.5);
+}
+
+void test_kernel() {
+    std::vector<double> u = {1.0, 2.0, 3.0, 4.0};
+    std::vector<double> u_in = {10.0, 20.0, 30.0, 40.0};
+    std::vector<double> out(u.size());
+    double gradient = 2.0;
+    double dx = 0.5;
+
+    std::vector<et::kernel<double>> variants;
+    variants.emplace_back(et::expr(u) * 0.0);
+    variants.emplace_back(et::expr(u_in) + gradient * et::expr(dx));
+    variants.push_back(variants[1]);
+    verify(variants.size() == 3 && variants[0] && variants[2].size() == 4);
+
+    variants[0](out);
+    verify(out == std::vector<double>(4, 0.0));
+    variants[2](out);
+    verify(out[3] == 41.0);
+
+    // chunks of a range, one indirect call each
+    std::fill(out.begin(), out.end(), 0.0);
+    variants[1](out, 0, 2);
+    variants[1](out, 2, 4);
+    verify(out[0] == 11.0 && out[3] == 41.0);
+
+    // expressions larger than the inline storage go to the heap
+    std::vector<double> big = {1.0, 1.0, 1.0, 1.0};
+    et::kernel<double, 16> k{et::expr(big) + 1.0 + 2.0 + 3.0 + 4.0 + 5.0};
+    et::kernel<double, 16> k2 = k;
+    et::kernel<double, 16> k3 = std::move(k);
+    verify(!k);
+    k3(out);
+    verify(out[0] == 16.0);
+    k2(out, 1, 2);
+    verify(out[1] == 16.0);
+}
+
+void test_codegen() {
+    // needs a compiler at run time
+    if (std::system("c++ --version > /dev/null 2>&1") != 0) {
+        std::cout << "codegen test skipped, no compiler\n";
+        return;
+    }
+    et::codegen::options opt;
+    opt.compiler = "c++";
+    opt.cache_dir = std::filesystem::temp_directory_path() / "et_codegen_test";
+    std::filesystem::remove_all(opt.cache_dir);
+
+    std::vector<double> a = {1.0, 4.0, 9.0, 16.0};
+    std::vector<float> b = {0.5f, 1.5f, 2.5f, 3.5f};
+    double c = 3.0;
+    auto e = sqrt(et::expr(a)) * c + et::expr(b) - et::lit<0.5>{};
+
+    et::codegen::source src = et::codegen::lower<double>(e);
+    verify(src.text.find("et::op::sqrt{}") != std::string::npos);
+    // constants are part of the source, scalars are arguments
+    verify(src.text.find("0x1p-1") != std::string::npos);
+    verify(src.text.find("args[2]") != std::string::npos && src.text.find("args[3]") == std::string::npos);
+
+    std::vector<double> expected(a.size());
+    std::vector<double> out(a.size());
+    et::assign(expected, e);
+    auto k = et::codegen::compile<double>(e, opt);
+    k(out, e);
+    verify(out == expected);
+
+    // same structure with other values: same object, loaded from the cache
+    double c2 = -1.0;
+    auto e2 = sqrt(et::expr(b)) * c2 + et::expr(b) - et::lit<0.5>{};
+    verify(et::codegen::lower<double>(e2).hash != src.hash);
+    c = -1.0;
+    k(out, e);
+    et::assign(expected, e);
+    verify(out == expected);
+    auto k2 = et::codegen::compile<double>(e, opt);
+    k2(out, e);
+    verify(out == expected);
+    std::size_t objects = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(opt.cache_dir)) {
+        objects += entry.path().extension() == ".so";
+    }
+    verify(objects == 1);
+
+    // in place with the source behind the destination, same result as et::assign
+    std::vector<double> u = {1.0, 2.0, 3.0, 4.0, 5.0};
+    std::vector<double> u_ref = u;
+    auto shifted = [] (std::vector<double>& w) {
+        return et::expr(std::span(w.data(), 4)) + et::expr(std::span(w.data() + 1, 4)) * 2.0;
+    };
+    et::assign(std::span(u_ref.data() + 1, 4), shifted(u_ref));
+    auto k3 = et::codegen::compile<double>(shifted(u), opt);
+    k3(std::span(u.data() + 1, 4), shifted(u));
+    verify(u == u_ref);
+
+    // compilation errors are reported
+    bool failed = false;
+    try {
+        et::codegen::load({"this is not C++", 1}, opt);
+    }
+    catch (const std::runtime_error&) {
+        failed = true;
+    }
+    verify(failed);
+    std::filesystem::remove_all(opt.cache_dir);
+}
+
+void test_solve_pointwise() {
+    // temperature from enthalpy, h = cp0 T + cp1 T^2 / 2
+    const double cp0 = 1000.0;
+    const double cp1 = 0.2;
+    std::vector<double> h;
+    for (int c = 0; c < 19; ++c) {
+        h.push_back(2.0e5 + 1.5e4 * c);
+    }
+    std::vector<double> T(h.size(), 300.0);
+    auto t = autodiff::var<0>(0.0);
+    auto r = cp0 * t + 0.5 * cp1 * t * t - et::expr(h);
+    et::pointwise_report report = et::solve_pointwise(r, t, T, 1e-14);
+    verify(report.ok() && report.iterations > 1 && report.iterations < 10);
+    for (std::size_t c = 0; c < h.size(); ++c) {
+        double exact = (-cp0 + std::sqrt(cp0 * cp0 + 2.0 * cp1 * h[c])) / cp1;
+        verify(std::abs(T[c] - exact) <= 1e-9 * exact);
+    }
+
+    // x exp(x) = y
+    std::vector<double> y = {0.5, 1.0, 2.0, 10.0};
+    std::vector<double> x(y.size(), 1.0);
+    auto w = autodiff::var<1>(0.0);
+    auto lambert = w * exp(w) - et::expr(y);
+    verify(et::solve_pointwise(lambert, w, x, 1e-14).ok());
+    for (std::size_t c = 0; c < y.size(); ++c) {
+        verify(std::abs(x[c] * std::exp(x[c]) - y[c]) <= 1e-12 * y[c]);
+    }
+
+    // no root: the lane keeps iterating until the limit, the others stop
+    std::vector<double> shift = {1.0, -1.0};
+    std::vector<double> z = {0.5, 0.5};
+    auto v = autodiff::var<2>(0.0);
+    auto no_root = v * v + et::expr(shift);
+    report = et::solve_pointwise(no_root, v, z, 1e-12, 20);
+    verify(report.unconverged == 1 && report.iterations == 20 && z[1] == 1.0);
+}
+
+void test_tensor() {
+    constexpr et::vec<double, 3> a{{1.0, 2.0, 3.0}};
+    constexpr et::vec<double, 3> b{{4.0, 5.0, 6.0}};
+    static_assert(et::dot(a, b) == 32.0);
+    static_assert(et::cross(a, b) == et::vec<double, 3>{{-3.0, 6.0, -3.0}});
+    static_assert(et::trace(et::outer(a, b)) == 32.0);
+    static_assert(et::transpose(et::outer(a, b)) == et::outer(b, a));
+    static_assert(et::dot(et::outer(a, b), a) == 32.0 * a);
+
+    // viscous stress from the velocity gradient, components stored separately
+    const std::size_t n = 5;
+    std::vector<double> gu(9 * n);
+    for (std::size_t k = 0; k < gu.size(); ++k) {
+        gu[k] = 0.1 * static_cast<double>(k) - 1.0;
+    }
+    std::vector<double> tu(9 * n);
+    std::vector<double> mu = {1.0, 2.0, 3.0, 4.0, 5.0};
+    et::soa_tensor<const double, 3, 3> grad_u(gu, n);
+    et::soa_tensor<double, 3, 3> tau(tu, n);
+    et::assign(tau, et::expr(mu) * (et::expr(grad_u) + et::transpose(et::expr(grad_u))));
+    for (std::size_t c = 0; c < n; ++c) {
+        for (std::size_t i = 0; i < 3; ++i) {
+            for (std::size_t j = 0; j < 3; ++j) {
+                verify(tu[(3 * i + j) * n + c] == mu[c] * (gu[(3 * i + j) * n + c] + gu[(3 * j + i) * n + c]));
+            }
+        }
+    }
+    verify(et::cost_v<std::remove_cvref_t<decltype(et::expr(grad_u))>>.bytes_loaded == 9 * sizeof(double));
+
+    // element-wise operations count once per component, transpose moves data only
+    using Tau = decltype(et::expr(mu) * (et::expr(grad_u) + et::transpose(et::expr(grad_u))));
+    static_assert(et::cost_v<Tau> == et::cost{.add = 9, .mul = 9, .bytes_loaded = 19 * sizeof(double)});
+    static_assert(et::assign_cost_v<decltype(tau), Tau>.bytes_stored == 9 * sizeof(double));
+    static_assert(et::cost_v<decltype(et::norm(et::expr(grad_u)))>.flops() == 18);
+    static_assert(et::cost_v<decltype(et::dot(et::expr(grad_u), et::expr(grad_u)))>.flops() == 45);
+    static_assert(et::cost_v<decltype(et::trace(et::expr(grad_u)) * 2.0)>.flops() == 3);
+
+    // reductions to scalars and vector results
+    std::vector<double> ux = {1.0, 0.0, 3.0, 0.0, 0.0};
+    std::vector<double> uy = {0.0, 1.0, 4.0, 0.0, 0.0};
+    std::vector<double> uz = {0.0, 0.0, 0.0, 2.0, 0.0};
+    et::soa_vector<double, 3> u({std::span(ux), std::span(uy), std::span(uz)});
+    std::vector<double> speed(n);
+    et::assign(speed, et::norm(et::expr(u)));
+    verify(speed == std::vector<double>({1.0, 1.0, 5.0, 2.0, 0.0}));
+    std::vector<double> div(n);
+    et::assign(div, et::trace(et::expr(tau)));
+    for (std::size_t c = 0; c < n; ++c) {
+        verify(div[c] == tu[c] + tu[4 * n + c] + tu[8 * n + c]);
+    }
+    std::vector<double> w(3 * n);
+    et::soa_vector<double, 3> omega(w, n);
+    const et::vec<double, 3> axis{{0.0, 0.0, 1.0}};
+    et::assign(omega, et::cross(axis, et::expr(u)) + et::dot(et::expr(grad_u), et::expr(u)));
+    // 9 for the cross product, 15 for the matrix-vector product, 3 for the sum
+    static_assert(et::cost_v<decltype(et::cross(axis, et::expr(u)) + et::dot(et::expr(grad_u), et::expr(u)))>.flops() == 27);
+    for (std::size_t c = 0; c < n; ++c) {
+        const et::vec<double, 3> uc = u[c];
+        const et::vec<double, 3> expected = et::cross(axis, uc) + et::dot(grad_u[c], uc);
+        verify(omega[c] == expected);
+    }
+}
+
+void test_poly() {
+    static_assert(et::horner(2.0, std::array{1.0, 2.0, 3.0}) == 17.0);
+    static_assert(et::estrin(2.0, std::array{1.0, 2.0, 3.0, 4.0, 5.0, 6.0}) == 321.0);
+    static_assert(et::estrin(2.0, std::array{1.0, 2.0, 3.0, 4.0, 5.0}) == 129.0);
+    static_assert(et::op::static_poly<1.0, 2.0, 3.0>{}(2.0) == 17.0);
+
+    // NASA-7 cp/R of N2, low and high temperature ranges
+    const std::array<double, 5> lo = {3.298677, 1.4082404e-3, -3.963222e-6, 5.641515e-9, -2.444854e-12};
+    const std::array<double, 5> hi = {2.92664, 1.4879768e-3, -5.68476e-7, 1.0097038e-10, -6.753351e-15};
+    auto naive = [] (const std::array<double, 5>& a, double t) {
+        return a[0] + a[1] * t + a[2] * t * t + a[3] * t * t * t + a[4] * t * t * t * t;
+    };
+    std::vector<double> T;
+    for (int c = 0; c < 37; ++c) {
+        T.push_back(300.0 + 100.0 * c);
+    }
+    std::vector<double> cp(T.size());
+    et::assign(cp, et::poly(et::expr(T), lo));
+    for (std::size_t c = 0; c < T.size(); ++c) {
+        verify(std::abs(cp[c] - naive(lo, T[c])) <= 1e-13 * std::abs(naive(lo, T[c])));
+    }
+    et::assign(cp, et::piecewise_poly(et::expr(T), std::array{1000.0}, std::array{lo, hi}));
+    for (std::size_t c = 0; c < T.size(); ++c) {
+        const double exact = naive(T[c] < 1000.0 ? lo : hi, T[c]);
+        verify(std::abs(cp[c] - exact) <= 1e-13 * std::abs(exact));
+    }
+    et::assign(cp, et::poly<1.0, -0.5>(et::expr(T)));
+    verify(cp[0] == -149.0);
+    verify(et::cost_v<std::remove_cvref_t<decltype(et::poly(et::expr(T), lo))>>.add == 4);
+
+    // temperature from the enthalpy polynomial h/R = sum a_k T^(k+1) / (k+1)
+    std::array<double, 6> h_lo = {0.0};
+    for (std::size_t k = 0; k < lo.size(); ++k) {
+        h_lo[k + 1] = lo[k] / static_cast<double>(k + 1);
+    }
+    std::vector<double> h(T.size());
+    std::vector<double> t_cold(T.size());
+    for (std::size_t c = 0; c < T.size(); ++c) {
+        t_cold[c] = std::min(T[c], 999.0);
+        h[c] = et::horner(t_cold[c], h_lo);
+    }
+    std::vector<double> x(T.size(), 500.0);
+    auto t = autodiff::var<0>(0.0);
+    auto r = et::poly(t, h_lo) - et::expr(h);
+    verify(et::solve_pointwise(r, t, x, 1e-14).ok());
+    for (std::size_t c = 0; c < T.size(); ++c) {
+        verify(std::abs(x[c] - t_cold[c]) <= 1e-10 * t_cold[c]);
+    }
+}
+
+void test_table() {
+    // linear interpolation reproduces linear functions, clamps outside the axis
+    et::uniform_axis<double> ax(0.0, 2.0, 21);
+    std::vector<double> lin(ax.n);
+    std::vector<double> sq(ax.n);
+    for (std::size_t i = 0; i < ax.n; ++i) {
+        lin[i] = 3.0 * ax.node(i) + 1.0;
+        sq[i] = ax.node(i) * ax.node(i);
+    }
+    et::table1d<double> f(ax, lin);
+    std::vector<double> x = {0.0, 0.05, 0.333, 1.0, 1.99, 2.0, -1.0, 5.0};
+    std::vector<double> y(x.size());
+    et::assign(y, 2.0 * f(et::expr(x)) + 1.0);
+    for (std::size_t c = 0; c < x.size(); ++c) {
+        const double xc = std::min(std::max(x[c], 0.0), 2.0);
+        verify(std::abs(y[c] - (2.0 * (3.0 * xc + 1.0) + 1.0)) <= 1e-13);
+    }
+    verify(std::isnan(f(std::nan(""))));
+
+    // cubic reproduces quadratics away from the end cells, with or without
+    // precomputed coefficients
+    et::table1d<double, et::uniform_axis<double>, et::interp::cubic> g(ax, sq);
+    et::table1d<double, et::uniform_axis<double>, et::interp::cubic_precomputed> gp(ax, sq);
+    for (double xc = 0.1; xc <= 1.9; xc += 0.0173) {
+        verify(std::abs(g(xc) - xc * xc) <= 1e-13);
+        verify(std::abs(gp(xc) - g(xc)) <= 1e-13);
+    }
+    verify(g(0.0) == 0.0 && g(2.0) == 4.0 && gp(1.0) == 1.0);
+    verify(std::abs(gp(0.05) - g(0.05)) <= 1e-14);
+
+    // log-spaced axis, linear in log(x)
+    et::log_axis<double> lx(1.0, 1e4, 9);
+    std::vector<double> lg(lx.n);
+    for (std::size_t i = 0; i < lx.n; ++i) {
+        lg[i] = std::log(lx.node(i));
+    }
+    et::table1d<double, et::log_axis<double>> h(lx, lg);
+    std::vector<double> p = {1.0, 3.0, 42.0, 777.0, 1e4};
+    std::vector<double> lp(p.size());
+    et::assign(lp, h(et::expr(p)));
+    for (std::size_t c = 0; c < p.size(); ++c) {
+        verify(std::abs(lp[c] - std::log(p[c])) <= 1e-12);
+    }
+
+    // functions of two variables
+    et::uniform_axis<double> ay(-1.0, 1.0, 11);
+    std::vector<double> plane(ax.n * ay.n);
+    std::vector<double> quad(ax.n * ay.n);
+    for (std::size_t i = 0; i < ax.n; ++i) {
+        for (std::size_t j = 0; j < ay.n; ++j) {
+            const double u = ax.node(i);
+            const double v = ay.node(j);
+            plane[i * ay.n + j] = u + 2.0 * v + 3.0;
+            quad[i * ay.n + j] = u * v + u * u - v * v;
+        }
+    }
+    et::table2d<double> bl(ax, ay, plane);
+    et::table2d<double, et::uniform_axis<double>, et::uniform_axis<double>, et::interp::cubic> bc(ax, ay, quad);
+    et::table2d<double, et::uniform_axis<double>, et::uniform_axis<double>, et::interp::cubic_precomputed> bp(ax, ay, quad);
+    std::vector<double> u = {0.15, 0.7, 1.23, 1.8};
+    std::vector<double> v = {-0.75, 0.05, 0.31, 0.77};
+    std::vector<double> z(u.size());
+    et::assign(z, bl(et::expr(u), et::expr(v)) - bc(et::expr(u), et::expr(v)));
+    for (std::size_t c = 0; c < u.size(); ++c) {
+        const double exact = u[c] * v[c] + u[c] * u[c] - v[c] * v[c];
+        verify(std::abs(z[c] - (u[c] + 2.0 * v[c] + 3.0 - exact)) <= 1e-12);
+        verify(std::abs(bp(u[c], v[c]) - exact) <= 1e-12);
+    }
+    verify(bl(et::expr(u), 0.5).arg2 == 0.5);
+    verify(et::cost_v<std::remove_cvref_t<decltype(h(et::expr(p)))>>.transcendental == 1);
+}
+
+int main() {
+    test_assign();
+    test_hoist();
+    test_assign_all();
+    test_cost();
+    test_profile();
+    test_task_graph();
+    test_aliasing();
+    test_arena();
+    test_streaming();
+    test_precision();
+    test_half();
+    test_nontemporal();
+    test_health();
+    test_kernel();
+    test_codegen();
+    test_solve_pointwise();
+    test_tensor();
+    test_poly();
+    test_table();
+}
@@ -7,10 +7,20 @@
 #include "et/graphviz.hpp"
 
 #include <cassert>
+#include <cmath>
+#include <cstdlib>
 #include <fstream>
 
 using namespace autodiff;
 
+bool verify(bool x) {
+    if (!x) {
+        std::cerr << "Fatal error\n";
+        std::exit(1);
+    }
+    return x;
+}
+
 void foo() {
     auto x = var<0>(1.0);
     auto y = var<1>(2);
@@ -68,6 +78,10 @@ void foo() {
     std::cout << "simplified = " << simp1 << " = " << et::evaluate(simp1) << '\n';
     auto dw_dy = derivative(w, y);
     std::cout << "dw/dy = " << dw_dy << '\n';
+
+    auto two = et::fold_constants(et::as_expr(one<double>{}) + one<double>{});
+    static_assert(std::is_same_v<decltype(two), et::lit<2.0>>);
+    std::cout << "1 + 1 = " << two << '\n';
 }
 
 //template<
@@ -203,6 +217,12 @@ void test2() {
         std::ofstream os("drho_dT.dot");
         write_dot_graph(os, drho_dT);
     }
+    {
+        std::ofstream dot("drho_dT_dag.dot");
+        write_dot_dag(dot, drho_dT);
+        std::ofstream json("drho_dT_dag.json");
+        write_json_dag(json, drho_dT);
+    }
 
     auto drhoE_dT = autodiff::derivative(rhoE, T);
     std::cout << "drhoE/dT = " << drhoE_dT << '\n';
@@ -212,7 +232,100 @@ void test2() {
 
 }
 
+// exp counting its evaluations
+struct counted_exp {
+    static inline int calls = 0;
+
+    template <typename X>
+    X operator()(const X& x) const {
+        ++calls;
+        return std::exp(x);
+    }
+};
+
+template <typename Arg>
+auto unary_function_derivative(const counted_exp& /*fn*/, Arg&& arg) {
+    return et::expr(counted_exp{}, std::forward<Arg>(arg));
+}
+
+void test_hessian() {
+    auto near = [] (double a, double b) { return std::abs(a - b) <= 1e-12 * (1.0 + std::abs(b)); };
+
+    auto x = var<0>(1.3);
+    auto y = var<1>(0.7);
+    auto f = x * x * y + sin(x) / y + et::ipow<3>(y);
+
+    auto h = hessian<0, 1>(f);
+    // (0, 1) and (1, 0) are one entry
+    static_assert(std::tuple_size_v<decltype(h.upper)> == 3);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(h.entry<0, 1>())>,
+                                 std::remove_cvref_t<decltype(h.entry<1, 0>())>>);
+
+    auto v = evaluate_all(h);
+    const double X = 1.3, Y = 0.7;
+    verify(near(v.gradient[0], 2 * X * Y + std::cos(X) / Y));
+    verify(near(v.gradient[1], X * X - std::sin(X) / (Y * Y) + 3 * Y * Y));
+    verify(near(v.hessian[0][0], 2 * Y - std::sin(X) / Y));
+    verify(near(v.hessian[0][1], 2 * X - std::cos(X) / (Y * Y)));
+    verify(v.hessian[1][0] == v.hessian[0][1]);
+    verify(near(v.hessian[1][1], 2 * std::sin(X) / (Y * Y * Y) + 6 * Y));
+
+    // structural zeros
+    auto g = cos(x * y) + y;
+    auto hg = hessian(g, x, y);
+    auto w = evaluate_all(hg);
+    verify(near(w.hessian[0][0], -std::cos(X * Y) * Y * Y));
+    verify(near(w.hessian[0][1], -std::cos(X * Y) * X * Y - std::sin(X * Y)));
+    verify(near(w.hessian[1][1], -std::cos(X * Y) * X * X));
+
+    auto l = x * 3.0 + y * y;
+    auto hl = hessian<0, 1>(l);
+    static_assert(hl.is_zero<0, 0> && hl.is_zero<0, 1> && !hl.is_zero<1, 1>);
+    verify(evaluate_all(hl).hessian[1][1] == 2.0);
+
+    std::cout << "d2f/dxdy = " << h.entry<0, 1>() << '\n';
+
+    // the shared subtree is evaluated once with its local first and second
+    // derivatives, however many entries contain it
+    auto z = var<2>(0.4);
+    auto c = et::expr(counted_exp{}, x * y * z) * x;
+    auto hc = hessian<0, 1, 2>(c);
+    counted_exp::calls = 0;
+    auto vc = evaluate_all(hc);
+    verify(counted_exp::calls == 3);
+    counted_exp::calls = 0;
+    evaluate_all(hessian<0>(c));
+    verify(counted_exp::calls == 3);
+
+    // the same entries evaluated as separate trees
+    counted_exp::calls = 0;
+    std::apply([&] (const auto&... d) { return std::array{evaluate(d)...}; }, hc.upper);
+    verify(counted_exp::calls > 10);
+    verify(near(vc.hessian[0][2], evaluate(hc.entry<0, 2>())));
+    verify(near(vc.hessian[1][1], evaluate(hc.entry<1, 1>())));
+    verify(near(vc.gradient[2], evaluate(std::get<2>(hc.gradient))));
+}
+
+void test_jacobian() {
+    auto x = var<0>(1.5);
+    auto y = var<1>(0.5);
+    auto z = var<2>(0.3);
+
+    auto j = jacobian(std::tuple(x * y, sin(z), x + z * z), x, y, z);
+    static_assert(j.rows == 3 && j.cols == 3 && j.nnz == 5);
+    static_assert(j.is_nonzero<0, 1> && !j.is_nonzero<0, 2> && !j.is_nonzero<1, 0> && !j.is_nonzero<2, 1>);
+    static_assert(j.row_offsets == std::array<std::size_t, 4>{0, 2, 3, 5});
+    static_assert(j.columns == std::array<std::size_t, 5>{0, 1, 2, 0, 2});
+
+    auto values = evaluate_all(j);
+    verify(values[0] == 0.5 && values[1] == 1.5);
+    verify(values[2] == std::cos(0.3));
+    verify(values[3] == 1.0 && values[4] == 2 * 0.3);
+}
+
 int main() {
     foo();
     test2();
+    test_hessian();
+    test_jacobian();
 }
@@ -6,6 +6,9 @@
 #include "et/math.hpp"
 #include "et/graphviz.hpp"
 #include "et/placeholders.hpp"
+#include "et/fold.hpp"
+#include "et/static_string.hpp"
+#include "et/poly.hpp"
 
 #include <iostream>
 #include <sstream>
@@ -109,6 +112,86 @@ void test_placeholders() {
     et::write_dot_graph(dot, (et::expr(_1) + _2) * _3 + _4);
 }
 
+void test_fold() {
+    constexpr auto c = (et::expr(et::lit<1>{}) + et::lit<2>{}) * et::lit<3>{};
+    static_assert(std::is_same_v<decltype(et::fold_constants(c)), et::lit<9>>);
+
+    // only the constant subtree is folded
+    double x = 2.0;
+    auto e = (et::expr(x) + std::integral_constant<int, 2>{}) * (et::expr(et::lit<0.5>{}) * et::lit<4>{});
+    auto f = et::fold_constants(e);
+    static_assert(std::is_same_v<decltype(f.arg2), et::lit<2.0>>);
+    test_print_eval(f, "(2 + 2) * 2", 8.0);
+}
+
+void test_dag() {
+    double x = 1.0;
+    double y = 2.0;
+    auto xy = et::expr(x) * y;
+    auto e = xy + sin(xy) * 2.0;
+
+    auto g = et::make_graph(e);
+    // x, y, x * y, sin, 2, *, +
+    verify(g.nodes.size() == 7);
+    verify(g.nodes[g.root].label == "+");
+    verify(g.nodes[g.root].tree_cost.flops() == 5);
+    verify(g.nodes[2].label == "*" && g.nodes[2].count == 2);
+
+    et::write_dot_dag(std::cout, g);
+    et::write_json_dag(std::cout, g);
+
+    // values equal in the printed digits are distinct nodes
+    auto g2 = et::make_graph(et::expr(1.0000001) + 1.0000002);
+    verify(g2.nodes.size() == 3);
+
+    // operations with different state are distinct nodes, with equal state shared
+    auto g3 = et::make_graph(et::poly(et::expr(x), 1.0, 2.0) + et::poly(et::expr(x), 1.0, 3.0));
+    verify(g3.nodes.size() == 4);
+    auto g4 = et::make_graph(et::poly(et::expr(x), 1.0, 2.0) + et::poly(et::expr(x), 1.0, 2.0));
+    verify(g4.nodes.size() == 3 && g4.nodes[1].count == 2);
+
+    // streaming writers produce the same output as the graph writers
+    std::ostringstream from_graph, streamed;
+    et::write_dot_dag(from_graph, g);
+    et::write_json_dag(from_graph, g);
+    et::write_dot_dag(streamed, e);
+    et::write_json_dag(streamed, e);
+    verify(from_graph.str() == streamed.str());
+}
+
+template<typename E>
+bool test_static_string(const E& e, std::string_view pattern)
+{
+    std::cout << "Static:     \"" << et::to_static_string<E>() << "\"\n";
+    verify(et::to_static_string<E>() == pattern);
+
+    std::ostringstream oss;
+    oss << e;
+    std::array<char, 64> buf;
+    auto [ptr, ec] = et::format_to(buf.data(), buf.data() + buf.size(), e);
+    verify(ec == std::errc{});
+    verify(std::string_view(buf.data(), ptr) == oss.str());
+
+    auto [ptr2, ec2] = et::format_to(buf.data(), buf.data() + 3, e);
+    verify(ec2 == std::errc::value_too_large);
+    return true;
+}
+
+void test_static_strings() {
+    static_assert(et::to_static_string<decltype((et::expr(8) + 9) + 1)>() == "({} + {}) + {}");
+    static_assert(et::to_static_string<decltype(et::expr(std::integral_constant<int, -12>{}) * 2)>() == "-12 * {}");
+
+    double x = 0.25;
+    test_static_string((et::expr(8) + 9) + 1, "({} + {}) + {}");
+    test_static_string(1 + (et::expr(8) + 9), "{} + ({} + {})");
+    test_static_string(-sqrt(et::expr(x) * 3.5), "-sqrt({} * {})");
+    test_static_string(select(true, et::expr(5) + 3, x), "select({}, {} + {}, {})");
+    test_static_string(et::expr(x) * et::lit<2>{}, "{} * 2");
+    test_static_string(et::expr(x) * et::lit<0.5>{} + et::lit<-1.25f>{}, "{} * {} + {}");
+    // values not representable in six digits are rounded like tr::print
+    test_static_string(et::expr(1.0 / 3) * 1e-7f + et::lit<2.0 / 3>{}, "{} * {} + {}");
+}
+
 int main() {
     test_print_eval(et::expr(3), "3", 3);
 
@@ -128,6 +211,12 @@ int main() {
 
     test_placeholders();
 
+    test_fold();
+
+    test_dag();
+
+    test_static_strings();
+
     auto simple_expr = et::expr(3) + 7;
     std::ofstream dot("simple_expr.dot");
     et::write_dot_graph(dot, simple_expr);